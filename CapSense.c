@@ -1,7 +1,7 @@
 /* CapSense.c
     Copyright (c) 2010, 2025 by Timothy J. Weber, tw@timothyweber.org.
 
-	Using capacitive touch sensing to simulate up to 4 pushbuttons.
+	Using capacitive touch sensing to simulate up to 8 pushbuttons.
 	Follows the guidelines set out in Microchip's AN1101 and AN1103.
 
     Readings are made of the time it takes to charge and discharge the touch pad, acting as a capacitor.
@@ -42,20 +42,65 @@
     For situations where periodic noise changes the environment, define
     a "domain" value that the caller can set to reflects any input variable
     that may change the capacitance of the system or the button pads.
+
+    Channels are normally read round-robin.  Define CS_ADAPTIVE_SCAN to read a channel that's
+    heading toward a press on every other interrupt, so its filtered reading gets there sooner.
+    The others are then read half as often, but never less than that.
+
+    To save power, define CS_IDLE_TICKS: once no button has been down for that long, only
+    CS_IDLE_CHANNEL is read, once every CS_IDLE_INTERVAL interrupts, with the comparators and
+    Timer 1 off in between.  The first reading that's more than halfway to its threshold
+    goes back to full-rate scanning.  The baselines carry on from where they were.
+    Touches on the other channels aren't seen at all while idle, so CS_IDLE_CHANNEL has to be
+    a guard or proximity pad that every touch affects; it must be defined along with CS_IDLE_TICKS.
+
+    Only one button is reported at a time by GetCapSenseButton().  Define CS_MULTI_TOUCH to also
+    track every channel's state separately, in csTouched, with a queue of presses and releases.
+
+    Adjacent pads can also be read together as a slider or wheel; see GetCapSenseSlider().
+
+    For tuning, define CS_CAPTURE to log the raw readings from the ISR, and replay them
+    through this same code on a PC with CapSenseReplay.c.
 */
 
 #define IN_CAPSENSE
 
+#ifdef CS_REPLAY
+#include "CapSenseReplay.h"
+#else
 #include <system.h>
 #include <memory.h>
+#endif
 #include <stdlib.h>
 
 #include "eeprom-tjw.h"
+#include "crc_8bit.h"
 #include "math-tjw.h"
 
 #include "CapSense.h"
 #include "CapSense-consts.h"
 
+// The filters divide by FILTER_LENGTH by shifting, so it has to be a power of 2.
+#ifndef FILTER_SHIFT
+	#if FILTER_LENGTH == 1
+		#define FILTER_SHIFT  0
+	#elif FILTER_LENGTH == 2
+		#define FILTER_SHIFT  1
+	#elif FILTER_LENGTH == 4
+		#define FILTER_SHIFT  2
+	#elif FILTER_LENGTH == 8
+		#define FILTER_SHIFT  3
+	#elif FILTER_LENGTH == 16
+		#define FILTER_SHIFT  4
+	#elif FILTER_LENGTH == 32
+		#define FILTER_SHIFT  5
+	#elif FILTER_LENGTH == 64
+		#define FILTER_SHIFT  6
+	#else
+		#error "FILTER_LENGTH must be a power of 2, up to 64."
+	#endif
+#endif
+
 // Some equivalent registers that are just named differently.
 #ifdef _PIC18F45K22
     #define ansel  ansela
@@ -71,15 +116,34 @@ byte currentCapSenseChannel;
 // The baseline value from which we expect low-going excursions when a finger approaches.
 CapSenseReading csBaseline[MAX_CAPSENSE_CHANNELS];
 
+// The reading below which each channel is pressed, before the domain offset is taken off:
+// the baseline less the channel's threshold from csThresholds, but no lower than CS_MIN_THRESHOLD.
+// Kept up to date whenever either of those changes, so the ISR doesn't work it out every time.
+CapSenseReading csPressThreshold[MAX_CAPSENSE_CHANNELS];
+
 #ifdef CS_AUTO_CALIBRATE
 // These are kept here during calibration; cleared by the calibration code.
 
 // The min reading for each channel seen during the current state.
 CapSenseReading csMin[MAX_CAPSENSE_CHANNELS];
+
+// Set for CapSenseStartFastCalibrate().
+byte csFastCalibrate;
+
+// The fast calibration's running mean and variance of each channel's readings, while nothing is pressed.
+// Worked out in the main loop, by CapSenseContinueCalibrate(); the ISR only flags each new reading in csNoiseFresh.
+// NOISE_SHIFT sets how many readings they average over (2^NOISE_SHIFT).
+// The filtered readings only vary by a few counts, so they're scaled up by 2^NOISE_SCALE first,
+// or the variance would round away to nothing.
+#define NOISE_SHIFT  4
+#define NOISE_SCALE  4
+signed long csNoiseMean[MAX_CAPSENSE_CHANNELS];
+unsigned long csNoiseVariance[MAX_CAPSENSE_CHANNELS];
+byte csNoiseFresh[MAX_CAPSENSE_CHANNELS];
 #endif
 
 // This is set if a button was pressed during the current bin - includes held down.
-byte csDownInBin[MAX_CAPSENSE_CHANNELS];
+byte csDownInBin[NUM_CAPSENSE_BINS];
 
 byte csLastBinTicks;
 
@@ -99,12 +163,82 @@ byte csHoldingButton;
 // if none have been pressed since the last call to GetCapSenseButton().
 byte csButton;
 
+#ifdef CS_ADAPTIVE_SCAN
+// The channel most recently seen more than halfway from its baseline to its threshold,
+// or NO_CAPSENSE_BUTTONS if none is.
+byte csHotChannel;
+
+// Set while the hot channel is being read out of turn.
+byte csScanExtra;
+
+// The channel to carry on the round-robin from, after that.
+byte csRoundRobinChannel;
+#endif
+
+#ifdef CS_IDLE_TICKS
+#ifndef CS_IDLE_CHANNEL
+	#error "Define CS_IDLE_CHANNEL in CapSense-consts.h, as a guard or proximity pad that every touch affects, to use CS_IDLE_TICKS."
+#endif
+#ifndef CS_IDLE_INTERVAL
+#define CS_IDLE_INTERVAL  16
+#endif
+
+// When csPollsSinceDown last reached 255.
+byte csQuietTicks;
+
+// Counts interrupts while idle, up to CS_IDLE_INTERVAL.
+byte csIdlePhase;
+#endif
+
+#ifdef CS_MULTI_TOUCH
+#ifndef CS_TOUCH_DEBOUNCE
+#define CS_TOUCH_DEBOUNCE  3
+#endif
+#ifndef CS_EVENT_LENGTH
+#define CS_EVENT_LENGTH  8
+#endif
+
+// Counts each channel's readings in a row that disagree with its bit in csTouched.
+byte csTouchChanging[MAX_CAPSENSE_CHANNELS];
+
+// Presses and releases, in a ring written by the ISR and read by GetCapSenseEvent(),
+// the same way as the capture ring below.
+CapSenseEvent csEvents[CS_EVENT_LENGTH];
+byte csEventHead;
+byte csEventTail;
+#endif
+
+#ifdef CS_CAPTURE
+// Raw readings, in a ring written by the ISR and read by GetCapSenseCapture().
+// Each side only moves its own index, so neither has to disable interrupts.
+CapSenseCapture csCapture[CS_CAPTURE_LENGTH];
+byte csCaptureHead;  // the next one to read
+byte csCaptureTail;  // the next one to write
+#endif
+
 
 //==================================================================
 // Main code
 
+#if MAX_CAPSENSE_CHANNELS > CS_CHIP_CHANNELS
+	#if !defined(CS_SELECT_EXTERNAL_MUX) && !defined(CS_REPLAY)
+	#error "Define CS_SELECT_EXTERNAL_MUX(channel) in CapSense-consts.h, to use more channels than the comparator has inputs."
+	#endif
+	#define CS_COMPARATOR_INPUT  (currentCapSenseChannel & (CS_CHIP_CHANNELS - 1))
+#else
+	#define CS_COMPARATOR_INPUT  currentCapSenseChannel
+#endif
+
+// True if comparator input n is read for any channel in CAPSENSE_CHANNELS, directly or through the multiplexer.
+#define CS_INPUT_USED(n)  (CS_CHANNEL_USED(n) || CS_CHANNEL_USED((n) + CS_CHIP_CHANNELS))
+
 inline void SetCapSenseChannel(void)
 {
+#ifndef CS_REPLAY
+	#if MAX_CAPSENSE_CHANNELS > CS_CHIP_CHANNELS
+	CS_SELECT_EXTERNAL_MUX(currentCapSenseChannel);
+	#endif
+	
 	// In addition to selecting the channel,
 	// these values connect the comparators to the right voltage references,
 	// and set their outputs to the inputs of the SR latch.
@@ -115,7 +249,7 @@ inline void SetCapSenseChannel(void)
         | BITMASK(C1SP)  // high speed
         #endif
         | BITMASK(C1R)  // C1Vin+ connects to C1Vref
-        | currentCapSenseChannel;
+        | CS_COMPARATOR_INPUT;
 	
 	// This also sets comparator 2's output to appear on the C2OUT pin, which
 	// is routed to charge and discharge all of the sensors in parallel.
@@ -128,11 +262,13 @@ inline void SetCapSenseChannel(void)
         #ifdef INTERNAL_LOW_REF
         | BITMASK(C2R)  // C2Vin+ connects to C2Vref instead of external C12IN+
         #endif
-        | currentCapSenseChannel;
+        | CS_COMPARATOR_INPUT;
+#endif
 }
 
 inline void RestartCapSenseTimer(void)
 {
+#ifndef CS_REPLAY
 	// Clear out and reset both timers.
 	// Timer 1 will start counting oscillations afresh,
 	// and Timer 0 will restart its count to 256 cycles till the interrupt.
@@ -142,6 +278,75 @@ inline void RestartCapSenseTimer(void)
 	tmr1h = 0;
 	t1con.TMR1ON = 1;
 	intcon.T0IF = 0;
+#endif
+}
+
+#ifdef CS_IDLE_TICKS
+// Turns off the relaxation oscillator and its counter, between idle readings.
+inline void StopCapSenseHardware(void)
+{
+#ifndef CS_REPLAY
+	t1con.TMR1ON = 0;
+	cm1con0.C1ON = 0;
+	cm2con0.C2ON = 0;
+#endif
+}
+#endif
+
+// Returns the press threshold for a channel with the given baseline and threshold from csThresholds.
+inline CapSenseReading PressThreshold(CapSenseReading baseline, byte sensitivity)
+{
+	// The threshold constant - sensitivity, but bracketed at the minimum threshold.
+	if (baseline > sensitivity) {
+		baseline -= sensitivity;
+		return max(baseline, CS_MIN_THRESHOLD);
+	} else
+		return CS_MIN_THRESHOLD;
+}
+
+void SetPressThresholds(void)
+{
+	byte channel;
+	for (channel = 0; channel < MAX_CAPSENSE_CHANNELS; channel++)
+		csPressThreshold[channel] = PressThreshold(csBaseline[channel], csThresholds[channel]);
+}
+
+void CapSenseThresholdsChanged(void)
+{
+	bit wasEnabled = intcon.GIE;
+	intcon.GIE = 0;
+	SetPressThresholds();
+	intcon.GIE = wasEnabled;
+}
+
+// The EEPROM record is the version, then CAPSENSE_EEPROM_LEN bytes of csThresholds, then this CRC of all of them.
+byte CalibrationCrc(void)
+{
+	Crc8Context ctx;
+	byte version = CS_CALIBRATION_VERSION;
+	
+	crc8InitContext(&ctx);
+	crc8Block(&ctx, &version, 1);
+	return crc8Block(&ctx, csThresholds, CAPSENSE_EEPROM_LEN);
+}
+
+void CapSenseLoadThresholds(void)
+{
+	byte channel;
+	
+	csCalibrationValid = false;
+	if (read_eeprom(CAPSENSE_EEPROM_ADDR) == CS_CALIBRATION_VERSION) {
+		read_eeprom_block(CAPSENSE_EEPROM_ADDR + 1, (char*) csThresholds, CAPSENSE_EEPROM_LEN);
+		csCalibrationValid = read_eeprom(CAPSENSE_EEPROM_ADDR + 1 + CAPSENSE_EEPROM_LEN) == CalibrationCrc();
+	}
+	
+	if (!csCalibrationValid) {
+		// Blank, from another version, or only partly written: fall back to the defaults.
+		for (channel = 0; channel < MAX_CAPSENSE_CHANNELS; channel++) {
+			csThresholds[channel] = CS_DEFAULT_THRESHOLD;
+			csThresholds[MAX_CAPSENSE_CHANNELS + channel] = 0;
+		}
+	}
 }
 
 // Returns true if the channel with the specified index is used, as defined by the constants in CapSense-consts.h.
@@ -152,7 +357,9 @@ byte IsChannelUsed(byte channel)
 
 void InitCapSense(void)
 {
-#if defined(_PIC16F886) || defined(_PIC16F887) || defined(_PIC18F45K22)
+#if defined(CS_REPLAY)
+	// No hardware to set up.
+#elif defined(_PIC16F886) || defined(_PIC16F887) || defined(_PIC18F45K22)
     // Set up the relaxation oscillator.
     // It's driven by C1, which detects the upper voltage threshold,
     // and C2, which detects the lower.
@@ -188,19 +395,19 @@ void InitCapSense(void)
         // The external voltage divider must be attached to comparator 2's + input, often RA2.
     #endif
 
-	#if CAPSENSE_CHANNELS & CAPSENSE_CHANNEL0
+	#if CS_INPUT_USED(0)
 	ansel.0 = 1;  // on RA0, AN0
 	trisa.0 = 1;
 	#endif
-	#if CAPSENSE_CHANNELS & CAPSENSE_CHANNEL1
+	#if CS_INPUT_USED(1)
 	ansel.1 = 1;  // on RA1, AN1
 	trisa.1 = 1;
 	#endif
-	#if CAPSENSE_CHANNELS & CAPSENSE_CHANNEL2
+	#if CS_INPUT_USED(2)
 	anselh.1 = 1;  // on RB3, AN9
 	trisb.3 = 1;
 	#endif
-	#if CAPSENSE_CHANNELS & CAPSENSE_CHANNEL3
+	#if CS_INPUT_USED(3)
 	anselh.2 = 1;  // on RB1, AN10
 	trisb.1 = 1;
 	#endif
@@ -234,7 +441,9 @@ void InitCapSense(void)
 
 	// Set up the interrupt on TMR0 overflow.
 	// It runs free, and we check TMR1's value on each TMR0 overflow interrupt.
+	#ifndef CS_REPLAY
 	InitUiTime_Timer0();
+	#endif
 	
 	// Clear all bins.
 	csCurrentBin = 0;
@@ -245,14 +454,37 @@ void InitCapSense(void)
 	csLastBinTicks = ticks;
 	csPollsSinceDown = 255;
 	csHoldingButton = NO_CAPSENSE_BUTTONS;
+	#ifdef CS_IDLE_TICKS
+	csIdle = false;
+	csQuietTicks = ticks;
+	#endif
+	#ifdef CS_ADAPTIVE_SCAN
+	csHotChannel = NO_CAPSENSE_BUTTONS;
+	csScanExtra = false;
+	#endif
 	memset(csDownInBin, 0, sizeof(csDownInBin));
 	
-	read_eeprom_block(CAPSENSE_EEPROM_ADDR, (char*) csThresholds, CAPSENSE_EEPROM_LEN);
+	CapSenseLoadThresholds();
+	SetPressThresholds();
 
 	SetCapSenseChannel();
 	RestartCapSenseTimer();
 	
 	csButton = NO_CAPSENSE_BUTTONS;
+	
+	#ifdef CS_MULTI_TOUCH
+	csTouched = 0;
+	memset(csTouchChanging, 0, sizeof(csTouchChanging));
+	csEventHead = 0;
+	csEventTail = 0;
+	csEventsDropped = 0;
+	#endif
+	
+	#ifdef CS_CAPTURE
+	csCaptureHead = 0;
+	csCaptureTail = 0;
+	csCaptureDropped = 0;
+	#endif
 }
 
 CapSenseReading GetLastCapSenseReading(byte index)
@@ -273,42 +505,197 @@ byte GetCapSenseButton(void)
 	return result;
 }
 
+#ifdef CS_SLIDER_CHANNELS
+// The last position reported, or CS_SLIDER_NONE.
+unsigned short csSliderPosition = CS_SLIDER_NONE;
+
+#define CS_SLIDER_RANGE  ((signed long) CS_SLIDER_CHANNELS * CS_SLIDER_RESOLUTION)
+
+unsigned short GetCapSenseSlider(void)
+{
+	// How far each pad is below its baseline.
+	// Copied with interrupts off, so the ISR can't change a reading halfway through.
+	CapSenseReading delta[CS_SLIDER_CHANNELS];
+	byte i;
+	bit wasEnabled = intcon.GIE;
+	intcon.GIE = 0;
+	for (i = 0; i < CS_SLIDER_CHANNELS; i++)
+		delta[i] = csBaseline[CS_SLIDER_FIRST_CHANNEL + i] - csReadings[CS_SLIDER_FIRST_CHANNEL + i];
+	intcon.GIE = wasEnabled;
+	
+	// Find the pad that's down the most.
+	byte peak = 0;
+	for (i = 0; i < CS_SLIDER_CHANNELS; i++) {
+		if (delta[i] < 0)
+			delta[i] = 0;
+		if (delta[i] > delta[peak])
+			peak = i;
+	}
+	
+	// Is it touched?  It takes the full threshold to start, but only half of it to carry on.
+	// It has to be down at all, too, even with a threshold under 2, or the centroid below would divide by 0.
+	byte threshold = csThresholds[CS_SLIDER_FIRST_CHANNEL + peak];
+	if (delta[peak] == 0
+		|| (csSliderPosition == CS_SLIDER_NONE ? delta[peak] < threshold : delta[peak] < (threshold >> 1))) {
+		csSliderPosition = CS_SLIDER_NONE;
+		return CS_SLIDER_NONE;
+	}
+	
+	// The neighbors on either side, wrapping around a wheel, or 0 past the ends of a slider.
+	CapSenseReading before = 0;
+	CapSenseReading after = 0;
+	#ifdef CS_SLIDER_WHEEL
+	before = delta[peak == 0 ? CS_SLIDER_CHANNELS - 1 : peak - 1];
+	after = delta[peak == CS_SLIDER_CHANNELS - 1 ? 0 : peak + 1];
+	#else
+	if (peak > 0)
+		before = delta[peak - 1];
+	if (peak < CS_SLIDER_CHANNELS - 1)
+		after = delta[peak + 1];
+	#endif
+	
+	// The centroid of the three pads, in steps from the first.
+	signed long position = (signed long) peak * CS_SLIDER_RESOLUTION
+		+ (signed long) CS_SLIDER_RESOLUTION * (after - before) / ((signed long) before + delta[peak] + after);
+	#ifdef CS_SLIDER_WHEEL
+	if (position < 0)
+		position += CS_SLIDER_RANGE;
+	else if (position >= CS_SLIDER_RANGE)
+		position -= CS_SLIDER_RANGE;
+	#endif
+	
+	// Only move if it's moved far enough, so it doesn't jitter between two steps.
+	if (csSliderPosition != CS_SLIDER_NONE) {
+		signed long moved = position - csSliderPosition;
+		#ifdef CS_SLIDER_WHEEL
+		// The short way around.
+		if (moved > CS_SLIDER_RANGE / 2)
+			moved -= CS_SLIDER_RANGE;
+		else if (moved < -CS_SLIDER_RANGE / 2)
+			moved += CS_SLIDER_RANGE;
+		#endif
+		if (moved < CS_SLIDER_HYSTERESIS && moved > -CS_SLIDER_HYSTERESIS)
+			return csSliderPosition;
+	}
+	
+	csSliderPosition = (unsigned short) position;
+	return csSliderPosition;
+}
+#endif
+
+#ifdef CS_MULTI_TOUCH
+// Debounces the current channel on its own, and queues an event when it changes.
+inline void UpdateCapSenseTouch(byte isDown)
+{
+	byte mask = 1 << currentCapSenseChannel;
+	byte* changing = &csTouchChanging[currentCapSenseChannel];
+	
+	// Still the same?
+	if (isDown ? (csTouched & mask) : !(csTouched & mask)) {
+		*changing = 0;
+		return;
+	}
+	
+	// It's changed, but wait for it to stay changed.
+	if (++*changing < CS_TOUCH_DEBOUNCE)
+		return;
+	*changing = 0;
+	csTouched ^= mask;
+	
+	byte next = csEventTail + 1;
+	if (next >= CS_EVENT_LENGTH)
+		next = 0;
+	if (next == csEventHead) {
+		if (csEventsDropped < 255)
+			++csEventsDropped;
+		return;
+	}
+	
+	csEvents[csEventTail].channel = currentCapSenseChannel;
+	csEvents[csEventTail].pressed = isDown;
+	csEvents[csEventTail].ticks = ticks;
+	csEventTail = next;
+}
+
+byte GetCapSenseEvent(CapSenseEvent* event)
+{
+	byte head = csEventHead;
+	if (head == csEventTail)
+		return false;
+		
+	*event = csEvents[head];
+	if (++head >= CS_EVENT_LENGTH)
+		head = 0;
+	csEventHead = head;
+	return true;
+}
+#endif
+
+#ifdef CS_CAPTURE
+inline void CaptureCapSenseReading(CapSenseReading reading)
+{
+	byte next = csCaptureTail + 1;
+	if (next >= CS_CAPTURE_LENGTH)
+		next = 0;
+		
+	if (next == csCaptureHead) {
+		// Full: drop this one, but count it, so the trace shows the gap.
+		if (csCaptureDropped < 255)
+			++csCaptureDropped;
+		return;
+	}
+	
+	csCapture[csCaptureTail].channel = currentCapSenseChannel;
+	csCapture[csCaptureTail].reading = reading;
+	csCaptureTail = next;
+}
+
+byte GetCapSenseCapture(CapSenseCapture* capture)
+{
+	byte head = csCaptureHead;
+	if (head == csCaptureTail)
+		return false;
+		
+	*capture = csCapture[head];
+	if (++head >= CS_CAPTURE_LENGTH)
+		head = 0;
+	csCaptureHead = head;
+	return true;
+}
+#endif
+
+// Returns the largest of one channel's bins.
+inline CapSenseReading MaxOfBins(CapSenseReading* bins)
+{
+#if NUM_CAPSENSE_BINS == 2
+	return max(bins[0], bins[1]);
+#else
+	CapSenseReading result = bins[0];
+	byte bin;
+	for (bin = 1; bin < NUM_CAPSENSE_BINS; bin++)
+		result = max(result, bins[bin]);
+	return result;
+#endif
+}
+
+// Unrolled over the channels, with CS_UNROLL_CHANNELS().
+#define CS_SET_BASELINE(n)  if (CS_CHANNEL_USED(n)) { \
+		csBaseline[n] = MaxOfBins(csBinMax[n]); \
+		csPressThreshold[n] = PressThreshold(csBaseline[n], csThresholds[n]); \
+	}
+#define CS_RESET_BIN(n)  if (CS_CHANNEL_USED(n)) csBinMax[n][csCurrentBin] = csReadings[n];
+#define CS_SKIP_UNUSED(n)  if (n > 0 && !CS_CHANNEL_USED(n) && currentCapSenseChannel == n) currentCapSenseChannel++;
+
 inline void BumpCapSenseBin(void)
 {
 	if (++csCurrentBin >= NUM_CAPSENSE_BINS)
 		csCurrentBin = 0;
 	
 	// Find the global max again, over all bins, for all channels.
-    #if NUM_CAPSENSE_BINS == 2
-    	#if CAPSENSE_CHANNELS & CAPSENSE_CHANNEL0
-    	csBaseline[0] = max(csBinMax[0][0], csBinMax[0][1]);
-    	#endif
-    	#if CAPSENSE_CHANNELS & CAPSENSE_CHANNEL1
-    	csBaseline[1] = max(csBinMax[1][0], csBinMax[1][1]);
-    	#endif
-    	#if CAPSENSE_CHANNELS & CAPSENSE_CHANNEL2
-    	csBaseline[2] = max(csBinMax[2][0], csBinMax[2][1]);
-    	#endif
-    	#if CAPSENSE_CHANNELS & CAPSENSE_CHANNEL3
-    	csBaseline[3] = max(csBinMax[3][0], csBinMax[3][1]);
-    	#endif
-    #else
-        #error "Recode the loop unrolling in BumpCapSenseBin() for this value of NUM_CAPSENSE_BINS."
-    #endif
+	CS_UNROLL_CHANNELS(CS_SET_BASELINE)
 
 	// Reset each channel's newly-current bin to contain just that channel's most-recent reading.
-	#if CAPSENSE_CHANNELS & CAPSENSE_CHANNEL0
-	csBinMax[0][csCurrentBin] = csReadings[0];
-	#endif
-	#if CAPSENSE_CHANNELS & CAPSENSE_CHANNEL1
-	csBinMax[1][csCurrentBin] = csReadings[1];
-	#endif
-	#if CAPSENSE_CHANNELS & CAPSENSE_CHANNEL2
-	csBinMax[2][csCurrentBin] = csReadings[2];
-	#endif
-	#if CAPSENSE_CHANNELS & CAPSENSE_CHANNEL3
-	csBinMax[3][csCurrentBin] = csReadings[3];
-	#endif
+	CS_UNROLL_CHANNELS(CS_RESET_BIN)
 	
 	csLastBinTicks = ticks;
 	csDownInBin[csCurrentBin] = false;
@@ -317,26 +704,46 @@ inline void BumpCapSenseBin(void)
         ++csBinSwitches;
 }
 
-inline void BumpCapSenseChannel(void)
+// Moves to the next channel in turn.
+inline void NextRoundRobinChannel(void)
 {
 	currentCapSenseChannel++;
 	
 	// Skip unused channels.
-	#if !(CAPSENSE_CHANNELS & CAPSENSE_CHANNEL1)
-	if (currentCapSenseChannel == 1)
-		currentCapSenseChannel++;
-	#endif
-	#if !(CAPSENSE_CHANNELS & CAPSENSE_CHANNEL2)
-	if (currentCapSenseChannel == 2)
-		currentCapSenseChannel++;
-	#endif
-	#if !(CAPSENSE_CHANNELS & CAPSENSE_CHANNEL3)
-	if (currentCapSenseChannel == 3)
-		currentCapSenseChannel++;
-	#endif
+	CS_UNROLL_CHANNELS(CS_SKIP_UNUSED)
 	
 	if (currentCapSenseChannel > LAST_CAPSENSE_CHANNEL)
 		currentCapSenseChannel = FIRST_CAPSENSE_CHANNEL;
+}
+
+inline void BumpCapSenseChannel(void)
+{
+#ifdef CS_IDLE_TICKS
+	if (csIdle) {
+		// Stay on the idle channel, with the hardware off till just before the next reading.
+		currentCapSenseChannel = CS_IDLE_CHANNEL;
+		StopCapSenseHardware();
+		return;
+	}
+#endif
+
+#ifdef CS_ADAPTIVE_SCAN
+	if (!csScanExtra && csHotChannel != NO_CAPSENSE_BUTTONS) {
+		// Read the hot channel next, out of turn.
+		csRoundRobinChannel = currentCapSenseChannel;
+		currentCapSenseChannel = csHotChannel;
+		csScanExtra = true;
+	} else {
+		// Pick up the round-robin where it left off.
+		if (csScanExtra) {
+			currentCapSenseChannel = csRoundRobinChannel;
+			csScanExtra = false;
+		}
+		NextRoundRobinChannel();
+	}
+#else
+	NextRoundRobinChannel();
+#endif
 		
 	SetCapSenseChannel();
 
@@ -344,85 +751,145 @@ inline void BumpCapSenseChannel(void)
 	RestartCapSenseTimer();
 }
 
-byte CapSenseISR(void)
+// Handles one raw reading from the current channel, and moves on to the next channel.
+inline void ProcessCapSenseReading(CapSenseReading reading)
 {
-	if (UiTimeInterrupt()) {
-        // Timer 0 has rolled over recently.
-		// Read TMR1: it's the number of times the oscillator has cycled since the last rollover.
-		CapSenseReading reading = (tmr1h << 8) | tmr1l;
-
-		// Do some of the indexing once.
-		CapSenseReading* currentBaseline = &csBaseline[currentCapSenseChannel];
-		CapSenseReading* currentReading = &csReadings[currentCapSenseChannel];
-		
-		// Compute the "pressed" threshold.
-		// threshold = the threshold constant - sensitivity, but bracketed at the minimum threshold.
-		CapSenseReading threshold = *currentBaseline;
-		byte sensitivity = csThresholds[currentCapSenseChannel];
-		if (threshold > sensitivity) {
-			threshold -= sensitivity;
-			threshold = max(threshold, CS_MIN_THRESHOLD);
-		} else
-			threshold = CS_MIN_THRESHOLD;
-		
-		// Filter the new value.
-		// Exponential weighted moving average, over FILTER_LENGTH samples.
-		reading = *currentReading + (reading - *currentReading) / FILTER_LENGTH;
-		*currentReading = reading;
-
-        // Subtract an offset for the domain.
-        if (csDomain)
-            threshold -= csThresholds[MAX_CAPSENSE_CHANNELS + currentCapSenseChannel];
-
-		// Is it a button press?
-		if (reading < threshold) {
-			// Yes, it's "down."
-			if (csButton == NO_CAPSENSE_BUTTONS && csHoldingButton == NO_CAPSENSE_BUTTONS
-				&& csPollsSinceDown > DEBOUNCE_POLLS  // debounce by number of polls - ~<= 1000/sec.
-			) {
-				// And this is the falling edge: note it.
-				csButton = currentCapSenseChannel;
-				csLastButtonTicks = ticks;
-				csHoldingButton = currentCapSenseChannel;
-				csPollsSinceDown = 0;
-				csDownInBin[csCurrentBin] = true;
+#ifdef CS_IDLE_TICKS
+	if (csIdle) {
+		// Skip all but every CS_IDLE_INTERVAL'th interrupt.
+		// Start up the hardware one interrupt early, so the reading covers a whole period.
+		if (++csIdlePhase < CS_IDLE_INTERVAL) {
+			if (csIdlePhase == CS_IDLE_INTERVAL - 1) {
+				SetCapSenseChannel();
+				RestartCapSenseTimer();
 			}
-		} else {
-			// No, it's not "down".
-			// If this is the button we were holding, we're not holding it anymore.
-			if (csHoldingButton == currentCapSenseChannel)
-				csHoldingButton = NO_CAPSENSE_BUTTONS;
-				
-			if (csHoldingButton == NO_CAPSENSE_BUTTONS && csPollsSinceDown < 255)
-				++csPollsSinceDown;
+			return;
+		}
+		csIdlePhase = 0;
+		
+		// Wake up on the raw reading, rather than waiting for the slow filter to get there.
+		// And stay awake for at least CS_IDLE_TICKS.
+		if (reading < csPressThreshold[CS_IDLE_CHANNEL] + (csThresholds[CS_IDLE_CHANNEL] >> 1)) {
+			csIdle = false;
+			csQuietTicks = ticks;
 		}
+	}
+#endif
+
+	// Do some of the indexing once.
+	CapSenseReading* currentReading = &csReadings[currentCapSenseChannel];
+	
+	// The "pressed" threshold, worked out when the baseline last changed.
+	CapSenseReading threshold = csPressThreshold[currentCapSenseChannel];
 	
-		// Update the current bin's maximum.
-		//accumulateMax<CapSenseReading>(&csBinMax[currentCapSenseChannel][csCurrentBin], reading);
-		// That works, but the resulting function call uses one too many stack levels.
-        CapSenseReading* currentMax = &csBinMax[currentCapSenseChannel][csCurrentBin];
-		if (reading > *currentMax)
-            // But use an exponential moving average instead of accumulating directly.
-			*currentMax = *currentMax + (reading - *currentMax) / FILTER_LENGTH;
-            // *currentMax = reading;
+	// Filter the new value.
+	// Exponential weighted moving average, over FILTER_LENGTH samples.
+	// This shifts instead of dividing, but rounds toward zero the same way.
+	ewmaUpdate<CapSenseReading>(currentReading, reading, FILTER_SHIFT);
+	reading = *currentReading;
+
+    // Subtract an offset for the domain.
+    if (csDomain)
+        threshold -= csThresholds[MAX_CAPSENSE_CHANNELS + currentCapSenseChannel];
+
+#ifdef CS_ADAPTIVE_SCAN
+	// Is it heading for a press (or in one)?  That's more than halfway from the baseline to the threshold.
+	if (reading < threshold + (csThresholds[currentCapSenseChannel] >> 1))
+		csHotChannel = currentCapSenseChannel;
+	else if (csHotChannel == currentCapSenseChannel)
+		csHotChannel = NO_CAPSENSE_BUTTONS;
+#endif
+
+#ifdef CS_MULTI_TOUCH
+	UpdateCapSenseTouch(reading < threshold);
+#endif
+
+	// Is it a button press?
+	if (reading < threshold) {
+		// Yes, it's "down."
+		if (csButton == NO_CAPSENSE_BUTTONS && csHoldingButton == NO_CAPSENSE_BUTTONS
+			&& csPollsSinceDown > DEBOUNCE_POLLS  // debounce by number of polls - ~<= 1000/sec.
+		) {
+			// And this is the falling edge: note it.
+			csButton = currentCapSenseChannel;
+			csLastButtonTicks = ticks;
+			csHoldingButton = currentCapSenseChannel;
+			csPollsSinceDown = 0;
+			csDownInBin[csCurrentBin] = true;
+		}
+	} else {
+		// No, it's not "down".
+		// If this is the button we were holding, we're not holding it anymore.
+		if (csHoldingButton == currentCapSenseChannel)
+			csHoldingButton = NO_CAPSENSE_BUTTONS;
+			
+		if (csHoldingButton == NO_CAPSENSE_BUTTONS && csPollsSinceDown < 255) {
+			++csPollsSinceDown;
+			#ifdef CS_IDLE_TICKS
+			if (csPollsSinceDown == 255)
+				csQuietTicks = ticks;
+			#endif
+		}
+	}
+	
+#ifdef CS_IDLE_TICKS
+	// Go idle if it's been quiet long enough.
+	if (!csIdle && csPollsSinceDown == 255 && ticks - csQuietTicks >= CS_IDLE_TICKS) {
+		csIdle = true;
+		csIdlePhase = 0;
+		#ifdef CS_ADAPTIVE_SCAN
+		csHotChannel = NO_CAPSENSE_BUTTONS;
+		csScanExtra = false;
+		#endif
+		// BumpCapSenseChannel() does the rest.
+	}
+#endif
+
+	// Update the current bin's maximum.
+	//accumulateMax<CapSenseReading>(&csBinMax[currentCapSenseChannel][csCurrentBin], reading);
+	// That works, but the resulting function call uses one too many stack levels.
+    CapSenseReading* currentMax = &csBinMax[currentCapSenseChannel][csCurrentBin];
+	if (reading > *currentMax)
+        // But use an exponential moving average instead of accumulating directly.
+		// The difference is positive, so a plain shift rounds the same as dividing.
+		*currentMax += (reading - *currentMax) >> FILTER_SHIFT;
+        // *currentMax = reading;
 
 #ifdef CS_AUTO_CALIBRATE
-		// During calibration, keep track of the minima as well.
-		if (csAutoCalibrateState == acPressAndReleaseButton)
-			accumulateMin<CapSenseReading>(&csMin[currentCapSenseChannel], reading);
+	// During calibration, keep track of the minima as well.
+	if (csFastCalibrate && csAutoCalibrateState == acPressNothing)
+		// The fast calibration measures the noise statistically instead, outside the ISR.
+		csNoiseFresh[currentCapSenseChannel] = true;
+	else if (csAutoCalibrateState == acPressAndReleaseButton
+		|| csAutoCalibrateState == acPressNothing
+		|| csAutoCalibrateState == acDomainBaselines)
+		accumulateMin<CapSenseReading>(&csMin[currentCapSenseChannel], reading);
 #endif		
-		
-		// Move to the next min bin, every once in a while.
-        // This allows us to adapt to changes in baseline capacitance (because it's gotten colder or wetter, e.g.)
-        // without adjusting too soon simply because the user has held a button down for a while.
-		if (ticks - csLastBinTicks >= TICKS_PER_BIN_CHANGE
-            || (csBinSwitches < NUM_CAPSENSE_BINS && ticks - csLastBinTicks >= TICKS_PER_BIN_CHANGE_INITIAL)
-            )
-			BumpCapSenseBin();
-	
-		// Move to the next sensor.
-		BumpCapSenseChannel();
 	
+	// Move to the next min bin, every once in a while.
+    // This allows us to adapt to changes in baseline capacitance (because it's gotten colder or wetter, e.g.)
+    // without adjusting too soon simply because the user has held a button down for a while.
+	if (ticks - csLastBinTicks >= TICKS_PER_BIN_CHANGE
+        || (csBinSwitches < NUM_CAPSENSE_BINS && ticks - csLastBinTicks >= TICKS_PER_BIN_CHANGE_INITIAL)
+        )
+		BumpCapSenseBin();
+
+	// Move to the next sensor.
+	BumpCapSenseChannel();
+}
+
+byte CapSenseISR(void)
+{
+	if (UiTimeInterrupt()) {
+        // Timer 0 has rolled over recently.
+		// Read TMR1: it's the number of times the oscillator has cycled since the last rollover.
+		CapSenseReading reading = (tmr1h << 8) | tmr1l;
+		
+		#ifdef CS_CAPTURE
+		CaptureCapSenseReading(reading);
+		#endif
+		
+		ProcessCapSenseReading(reading);
 		return true;
 	} else
 		return false;
@@ -473,18 +940,56 @@ void InitReadingArray(CapSenseReading* array, byte count, CapSenseReading value)
 
 inline void EnterState(CSAutoCalibrateState newState)
 {
+	// Each state collects its own minima.
+	InitReadingArray(csMin, MAX_CAPSENSE_CHANNELS, MAX_CS_READING);
 	csAutoCalibrateState = newState;
 	ticksStateStart = ticks;
 }
 
 void CapSenseStartCalibrate(void)
 {
+	csFastCalibrate = false;
+	EnterState(acStart);
+}
+
+void CapSenseStartFastCalibrate(void)
+{
+	csFastCalibrate = true;
 	EnterState(acStart);
 }
 
 void CapSenseSaveThresholds(void)
 {
-    write_eeprom_block(CAPSENSE_EEPROM_ADDR, (char*) csThresholds, CAPSENSE_EEPROM_LEN);
+	// The CRC goes last, so a write that's cut short won't be loaded.
+	write_eeprom(CAPSENSE_EEPROM_ADDR, CS_CALIBRATION_VERSION);
+	write_eeprom_block(CAPSENSE_EEPROM_ADDR + 1, (char*) csThresholds, CAPSENSE_EEPROM_LEN);
+	write_eeprom(CAPSENSE_EEPROM_ADDR + 1 + CAPSENSE_EEPROM_LEN, CalibrationCrc());
+}
+
+// Adds each channel's reading to the noise statistics, if the ISR has made a new one since the last call.
+// Readings that come faster than this is called are skipped, which only makes the sample smaller.
+void UpdateNoiseStatistics(void)
+{
+	byte channel;
+	byte fresh;
+	CapSenseReading reading;
+	
+	for (channel = FIRST_CAPSENSE_CHANNEL; channel <= LAST_CAPSENSE_CHANNEL; ++channel) {
+		intcon.GIE = 0;
+		fresh = csNoiseFresh[channel];
+		csNoiseFresh[channel] = false;
+		reading = csReadings[channel];
+		intcon.GIE = 1;
+		
+		if (fresh)
+			ewmVarianceUpdate<signed long>(&csNoiseMean[channel], &csNoiseVariance[channel], (signed long) reading << NOISE_SCALE, NOISE_SHIFT);
+	}
+}
+
+// The number of times through the buttons for the current calibration.
+inline byte CalibrationPasses(void)
+{
+	return csFastCalibrate ? 1 : TIMES_THRU_BUTTONS;
 }
 
 byte CapSenseContinueCalibrate(void)
@@ -504,18 +1009,39 @@ byte CapSenseContinueCalibrate(void)
 		timesThruButtons = 0;
 		InitReadingArray(csMaxWaiting, MAX_CAPSENSE_CHANNELS, 0);
         InitReadingArray(csMaxWaitingInDomain, MAX_CAPSENSE_CHANNELS, 0);
-		InitReadingArray(csMaxHolding, MAX_CAPSENSE_CHANNELS * TIMES_THRU_BUTTONS, 0);
+		InitReadingArray((CapSenseReading*) csMaxHolding, MAX_CAPSENSE_CHANNELS * TIMES_THRU_BUTTONS, 0);
 		InitReadingArray(csMaxOthers, MAX_CAPSENSE_CHANNELS, 0);
+		if (csFastCalibrate) {
+			// Start the noise statistics from the current readings.
+			intcon.GIE = 0;
+			for (channel = 0; channel < MAX_CAPSENSE_CHANNELS; ++channel) {
+				csNoiseMean[channel] = (signed long) csReadings[channel] << NOISE_SCALE;
+				csNoiseVariance[channel] = 0;
+				csNoiseFresh[channel] = false;
+			}
+			intcon.GIE = 1;
+		}
 		EnterState(acPressNothing);
 		break;
 		
 	case acPressNothing:
     case acDomainBaselines:
+		if (csFastCalibrate)
+			UpdateNoiseStatistics();
+			
 		if (ticks - ticksStateStart > SETTLE_TICKS) {
 			// Done waiting.
 			// Move mins into csMinWaiting.
 			for (channel = FIRST_CAPSENSE_CHANNEL; channel <= LAST_CAPSENSE_CHANNEL; ++channel)
-                if (csAutoCalibrateState == acPressNothing)
+                if (csFastCalibrate) {
+					// The noise floor is as far as the average reading sits below the baseline,
+					// plus CS_NOISE_SIGMAS standard deviations.
+					CapSenseReading mean = csNoiseMean[channel] >> NOISE_SCALE;
+					
+					csMaxWaiting[channel] = ((unsigned long) CS_NOISE_SIGMAS * sqrtUnsigned(csNoiseVariance[channel])) >> NOISE_SCALE;
+					if (csBaseline[channel] > mean)
+						csMaxWaiting[channel] += csBaseline[channel] - mean;
+				} else if (csAutoCalibrateState == acPressNothing)
 				    accumulateMax<CapSenseReading>(&csMaxWaiting[channel], csBaseline[channel] - csMin[channel]);
                 else
                     accumulateMax<CapSenseReading>(&csMaxWaitingInDomain[channel], csBaseline[channel] - csMin[channel]);
@@ -559,16 +1085,14 @@ byte CapSenseContinueCalibrate(void)
 			while (!IsChannelUsed(csCalButton) && csCalButton <= LAST_CAPSENSE_CHANNEL)
 				++csCalButton;
 
-			// Reset the csMin for this button and pass.
-			InitReadingArray(csMin, MAX_CAPSENSE_CHANNELS, MAX_CS_READING);
-
 			// Start a new round, if we've been through all channels.
 			if (csCalButton > LAST_CAPSENSE_CHANNEL) {
 				csCalButton = FIRST_CAPSENSE_CHANNEL;
 				++timesThruButtons;
 				
-				if (timesThruButtons >= TIMES_THRU_BUTTONS)
-					EnterState(acPressNothing);
+				if (timesThruButtons >= CalibrationPasses())
+					// The fast calibration is done after one pass; it keeps the domain offsets it had.
+					EnterState(csFastCalibrate ? acDone : acPressNothing);
 			} 
 		}
 		break;
@@ -588,7 +1112,7 @@ byte CapSenseContinueCalibrate(void)
 				CapSenseReading minMe = MAX_CS_READING;  // the smallest maximum excursion for the weakest press
 				CapSenseReading maxMe = 0;  // the largest excursion for the strongest press
 				byte i;
-				for (i = 0; i < TIMES_THRU_BUTTONS; ++i) {
+				for (i = 0; i < CalibrationPasses(); ++i) {
 					minMe = min(minMe, csMaxHolding[csCalButton][i]);
 					maxMe = max(maxMe, csMaxHolding[csCalButton][i]);
 				}
@@ -606,7 +1130,11 @@ byte CapSenseContinueCalibrate(void)
 				} else {
 					// Otherwise, report the excursion distance from the steady-state "waiting" reading
 					// that will recognize the weakest button press, with a slight margin to ensure it's read as a press.
-					csThresholds[csCalButton] = minMe - CS_MIN_THRESHOLD;
+					// With only one press to go on, the fast calibration splits the difference with the noise instead.
+					if (csFastCalibrate)
+						csThresholds[csCalButton] = (minMe / 2) + (maxWaiting / 2);
+					else
+						csThresholds[csCalButton] = minMe - CS_MIN_THRESHOLD;
 				
 					// If the weakest button press isn't distinguishable from noise or other buttons, note that
 					// this button is just "OK" - you have to press it hard.
@@ -621,7 +1149,8 @@ byte CapSenseContinueCalibrate(void)
 				}
 
                 // Set the domain offset.
-                csThresholds[MAX_CAPSENSE_CHANNELS + csCalButton] = maxWaitingInDomain;
+                if (!csFastCalibrate)
+                    csThresholds[MAX_CAPSENSE_CHANNELS + csCalButton] = maxWaitingInDomain;
 			} else {
 				// Blank out the results for unused buttons, just for completeness.
 				csResults[csCalButton] = acrFail;
@@ -630,6 +1159,8 @@ byte CapSenseContinueCalibrate(void)
 			}
 		}
 	
+		CapSenseThresholdsChanged();
+	
 		// Copy intermediate results to the start of EEPROM, so they can be conveniently read out.
 		// Overwrites whatever's there (ASCII table for the display at the moment).
 		#if 0
@@ -1,7 +1,7 @@
 /* CapSense.h
     Copyright (c) 2010, 2025 by Timothy J. Weber, tw@timothyweber.org.
     
-	Using capacitive touch sensing to simulate up to 4 pushbuttons.
+	Using capacitive touch sensing to simulate up to 8 pushbuttons.
 	Follows the guidelines set out in Microchip's AN1101 and AN1103.
     Uses the Charge Time Measurement approach.
 	
@@ -16,6 +16,8 @@
 	Requires:
 		types-tjw
 		uiTime (which it initializes and updates)
+		eeprom-tjw
+		crc_8bit
 		
 	Call InitCapSense(), and CapSenseISR() and CapSenseISRDone() as described below.
 	Then call GetCapSenseButton() to process buttons.
@@ -37,7 +39,31 @@
 #endif
 
 
-#define MAX_CAPSENSE_CHANNELS  4
+// The number of comparator inputs the chip can switch among.
+// On all of the supported chips, channels 0-3 are C12IN0- to C12IN3-.
+#define CS_CHIP_CHANNELS  4
+
+// Define MAX_CAPSENSE_CHANNELS in CapSense-consts.h for more channels than that, up to 8.
+// The extra ones have to come through an external analog multiplexer in front of the comparator inputs:
+// channel n is read on input n % CS_CHIP_CHANNELS, after CS_SELECT_EXTERNAL_MUX(n) is called to
+// switch the multiplexer, which the project defines in CapSense-consts.h too.
+#ifndef MAX_CAPSENSE_CHANNELS
+#define MAX_CAPSENSE_CHANNELS  CS_CHIP_CHANNELS
+#endif
+#if MAX_CAPSENSE_CHANNELS > 8
+#error "CapSense supports at most 8 channels."
+#endif
+
+// True if channel n is in CAPSENSE_CHANNELS.  A constant, for constant n.
+#define CS_CHANNEL_USED(n)  (CAPSENSE_CHANNELS & (1 << (n)))
+
+// Expands X(n) for every channel number below MAX_CAPSENSE_CHANNELS (rounded up to 4 or 8),
+// to unroll loops over the channels.  X(n) should test CS_CHANNEL_USED(n), so unused channels cost nothing.
+#if MAX_CAPSENSE_CHANNELS > 4
+#define CS_UNROLL_CHANNELS(X)  X(0) X(1) X(2) X(3) X(4) X(5) X(6) X(7)
+#else
+#define CS_UNROLL_CHANNELS(X)  X(0) X(1) X(2) X(3)
+#endif
 
 
 typedef signed short CapSenseReading;
@@ -45,7 +71,11 @@ typedef signed short CapSenseReading;
 
 
 // These are just in the header to facilitate debugging.
+// Define NUM_CAPSENSE_BINS in CapSense-consts.h for a longer baseline window:
+// the baseline follows the readings down after about TICKS_PER_BIN_CHANGE * NUM_CAPSENSE_BINS ticks.
+#ifndef NUM_CAPSENSE_BINS
 #define NUM_CAPSENSE_BINS  2
+#endif
 #define NUM_CAPSENSE_DOMAINS  2
 // The maximum reading, per channel, in multiple bins so we can refer to previous maxes while accumulating a new one.
 CAPSENSE_EXTERN CapSenseReading csBinMax[MAX_CAPSENSE_CHANNELS][NUM_CAPSENSE_BINS];
@@ -62,7 +92,7 @@ CAPSENSE_EXTERN byte csDomain;
 void InitCapSense(void);
 
 // Returns NO_CAPSENSE_BUTTONS if no buttons have been pressed,
-// or 0-3 if a corresponding button has been pressed.
+// or the channel number (0 to MAX_CAPSENSE_CHANNELS - 1) if a corresponding button has been pressed.
 // Channels correspond to the various negative input pins to Comparators 1 & 2.
 // On the PIC16F886, e.g., there are four negative input pins, shared with both comparators,
 // on RA0, RA1, RB3, and RB1, in that order (channels 0-3 respectively).
@@ -72,8 +102,57 @@ void InitCapSense(void);
 byte GetCapSenseButton(void);
 
 
+// Define CS_MULTI_TOUCH in CapSense-consts.h to track each channel separately, so that
+// buttons held together, or rolled from one to the next, are all seen.
+// Each channel has to read the other way CS_TOUCH_DEBOUNCE times in a row to change.
+// GetCapSenseButton() carries on working as before, alongside these.
+#ifdef CS_MULTI_TOUCH
+
+// A bit for each channel that's down now (bit n for channel n).
+CAPSENSE_EXTERN byte csTouched;
+
+typedef struct {
+	byte channel;
+	byte pressed;  // true when pressed, false when released
+	byte ticks;  // the value of ticks when it happened
+} CapSenseEvent;
+
+// Copies the oldest press or release into event, and returns true;
+// or returns false if there are none.  Up to CS_EVENT_LENGTH - 1 are kept (7 by default).
+byte GetCapSenseEvent(CapSenseEvent* event);
+
+// The number of events dropped because the queue was full, up to 255.
+CAPSENSE_EXTERN byte csEventsDropped;
+
+#endif
+
+// Define CS_SLIDER_CHANNELS in CapSense-consts.h to read that many adjacent pads,
+// from CS_SLIDER_FIRST_CHANNEL on, as a slider; also define CS_SLIDER_WHEEL if they go around in a circle.
+// Call GetCapSenseSlider() from the main loop (it divides, and briefly disables interrupts).
+// It returns the finger's position, as the centroid of the pad that's down the most and its two neighbors,
+// in steps of 1/CS_SLIDER_RESOLUTION of the distance between pads: from 0 at the first pad to
+// (CS_SLIDER_CHANNELS - 1) * CS_SLIDER_RESOLUTION at the last, or around a wheel,
+// up to CS_SLIDER_CHANNELS * CS_SLIDER_RESOLUTION - 1.
+// It returns CS_SLIDER_NONE if the slider isn't being touched: the full threshold from csThresholds
+// is needed to start, but half that is enough to carry on.
+// The position only changes when it moves by at least CS_SLIDER_HYSTERESIS steps.
+// The pads are still reported by GetCapSenseButton(), too.
+#ifdef CS_SLIDER_CHANNELS
+#ifndef CS_SLIDER_FIRST_CHANNEL
+#define CS_SLIDER_FIRST_CHANNEL  FIRST_CAPSENSE_CHANNEL
+#endif
+#ifndef CS_SLIDER_RESOLUTION
+#define CS_SLIDER_RESOLUTION  64
+#endif
+#ifndef CS_SLIDER_HYSTERESIS
+#define CS_SLIDER_HYSTERESIS  (CS_SLIDER_RESOLUTION / 8)
+#endif
+#define CS_SLIDER_NONE  0xFFFF
+unsigned short GetCapSenseSlider(void);
+#endif
+
 #ifdef DEBUG
-// Returns the last reading from the given sensor (0-3).
+// Returns the last reading from the given sensor.
 // (Readings are filtered before they're accessed here.)
 CapSenseReading GetLastCapSenseReading(byte index);
 
@@ -84,6 +163,12 @@ CapSenseReading GetBaseline(byte index);
 //==================================================================
 // Interrupt routines.
 
+#ifdef CS_IDLE_TICKS
+// True while scanning slowly, to save power; see CapSense.c.
+// The main loop can use this to decide whether it can sleep longer, too.
+CAPSENSE_EXTERN byte csIdle;
+#endif
+
 // Call this first in the main ISR.
 // It returns true if there was a Timer0 interrupt.
 // It's inline (and therefore so is much of this module) to save the call/return overhead in the ISR,
@@ -94,20 +179,84 @@ byte CapSenseISR(void);
 void CapSenseISRDone(void);
 
 
+//==================================================================
+// Capture, for tuning offline.
+
+// Define CS_CAPTURE in CapSense-consts.h to have the ISR keep each raw Timer 1 reading,
+// before any filtering, in a ring of CS_CAPTURE_LENGTH entries.
+// Drain it from the main loop with GetCapSenseCapture(), and send the entries out
+// (over serial or BasicBus, e.g.) as lines of "channel reading", in decimal.
+// CapSenseReplay.c runs such a trace back through the same code on a PC.
+#ifdef CS_CAPTURE
+
+#ifndef CS_CAPTURE_LENGTH
+#define CS_CAPTURE_LENGTH  16
+#endif
+
+typedef struct {
+	byte channel;
+	CapSenseReading reading;
+} CapSenseCapture;
+
+// Copies the oldest captured reading into capture, and returns true;
+// or returns false if there are none.
+byte GetCapSenseCapture(CapSenseCapture* capture);
+
+// The number of readings dropped because the ring was full, up to 255.
+// Clear it after reporting it.
+CAPSENSE_EXTERN byte csCaptureDropped;
+
+#endif
+
+
 //==================================================================
 // Calibration
 
 // Thresholds come first, followed by the domain offsets.
 CAPSENSE_EXTERN byte csThresholds[NUM_CAPSENSE_DOMAINS * MAX_CAPSENSE_CHANNELS];
 
+// The first CAPSENSE_EEPROM_LEN bytes of csThresholds are kept in EEPROM at CAPSENSE_EEPROM_ADDR,
+// after a version byte and followed by a CRC-8 of both, so the record takes CAPSENSE_EEPROM_LEN + 2 bytes.
+// Change CS_CALIBRATION_VERSION when the meaning of the thresholds changes, to make old records invalid.
+#ifndef CS_CALIBRATION_VERSION
+#define CS_CALIBRATION_VERSION  1
+#endif
+
+// If the record is blank or doesn't check out, each channel gets this threshold, and no domain offset.
+#ifndef CS_DEFAULT_THRESHOLD
+#define CS_DEFAULT_THRESHOLD  (4 * CS_MIN_THRESHOLD)
+#endif
+
+// Reads csThresholds from EEPROM, or sets the defaults.  InitCapSense() calls this.
+// Call CapSenseThresholdsChanged() afterwards, if you call it again later.
+void CapSenseLoadThresholds(void);
+
+// True if csThresholds came from a good EEPROM record.
+CAPSENSE_EXTERN byte csCalibrationValid;
+
+// Call this after changing csThresholds directly.
+// Briefly disables interrupts.
+void CapSenseThresholdsChanged(void);
+
 // Turn this on in CapServe-consts.h to enable the functions below.
 #ifdef CS_AUTO_CALIBRATE
 
 // Call this to start the calibration.
 void CapSenseStartCalibrate(void);
 
+// Or this, to start a shorter calibration, for the production line:
+// it measures the noise statistically while nothing is pressed, and needs just one press of each button.
+// It skips acDomainBaselines, and keeps the domain offsets already in csThresholds.
+// Define CS_NOISE_SIGMAS in CapSense-consts.h to set how many standard deviations above the noise
+// a press has to be (the default is 4).
+void CapSenseStartFastCalibrate(void);
+#ifndef CS_NOISE_SIGMAS
+#define CS_NOISE_SIGMAS  4
+#endif
+
 // Call this repeatedly to run the calibration.
 // Stop calling it when it returns false; calibration is done.
+// The fast calibration samples the noise each time it's called, so call it at least once per reading if you can.
 // While calibration is under way, tell the user what state we're in using the variables below.
 byte CapSenseContinueCalibrate(void);
 
@@ -115,7 +264,7 @@ typedef enum {
 	acStart,  // Beginning calibration.  Occurs only briefly.
 	acPressNothing,  // Don't press any buttons now.  Done after start and before domain baselines.
 	acPressAndReleaseButton,  // Press and release the button specified in csButton.  
-		// This state is done three times for each button;
+		// This state is done twice for each button (once for the fast calibration);
 		// recommended input is a light tap on each button.
     acDomainBaselines,  // Don't press any buttons; measures change in thresholds with new domain.
 	acDone  // Finished calibration.
@@ -134,6 +283,7 @@ typedef enum {
 CAPSENSE_EXTERN CSAutoCalibrateResult csResults[MAX_CAPSENSE_CHANNELS];
 
 // Save csThresholds to EEPROM, so they'll be restored later.
+// Writes the versioned record described at CS_CALIBRATION_VERSION.
 void CapSenseSaveThresholds(void);
 
 #endif
@@ -0,0 +1,247 @@
+/* CapSenseReplay.c
+    Copyright (c) 2026 by Timothy J. Weber, tw@timothyweber.org.
+
+	Replays readings captured with CS_CAPTURE through the same filtering, detection and
+	baseline code as CapSenseISR(), on a PC, and reports how well the buttons were detected.
+	This makes it quick to try other FILTER_LENGTH, DEBOUNCE_POLLS, TICKS_PER_BIN_CHANGE
+	and threshold values against the same recordings.
+
+	Build with a PC's C++ compiler, with the project's CapSense-consts.h on the include path:
+		g++ -x c++ -funsigned-char -DCS_REPLAY -I <project> -I <this library> CapSenseReplay.c -o csreplay
+	and run it with the thresholds, then the domain offsets, in the order of csThresholds:
+		csreplay 40 40 35 35 0 0 0 0 < trace.txt
+
+	The trace has one entry per line:
+		channel reading		a raw reading, in decimal, as logged from GetCapSenseCapture()
+		f r0 r1 r2 ...		what every channel would read at this interrupt (from a model, or
+					interpolated from a capture); CapSense.c picks which one it reads,
+					so changes to the scan order can be tried
+		d channel		from here on, that button is being touched (added by hand, or by a test rig)
+		u			from here on, no button is being touched
+		D domain		sets csDomain
+		m n base noise depth	makes up n readings from a model: base, plus or minus up to noise at random,
+					less depth on the button being touched
+		c, C			with CS_AUTO_CALIBRATE, starts a full or fast calibration; while it runs,
+					the model taps whichever button it asks for, csDomain is set to 1 for
+					acDomainBaselines (as the application would), and the results are printed
+	Anything else, like a "#" comment, is skipped.
+	For instance, this runs the fast calibration against a model, and then a touch of button 1:
+		printf "m 1000 2000 6 175\nC\nm 6000 2000 6 175\nd 1\nm 300 2000 6 175\nu\nm 300 2000 6 175\n" | csreplay
+
+	Each reading stands for one Timer 0 interrupt, about 1 ms; the buttons are polled after each one.
+	Detection latency is counted in readings from the "d" line to the button being reported.
+	A button reported when none is touched, or another one is, counts as a false positive.
+	With CS_IDLE_TICKS, it also reports how much of the time was spent idle, and the latency
+	for touches that began while idle, which includes waking up.
+	Cycle counts for the ISR still have to come from the simulator; as a stand-in, this counts
+	how often it took its longest path, through BumpCapSenseBin().
+*/
+
+#include "CapSense.c"
+
+#include <stdlib.h>
+
+typedef struct {
+	unsigned long touches;
+	unsigned long detected;
+	unsigned long falsePositives;
+	unsigned long latencySum;
+	unsigned long latencyMax;
+} ReplayStats;
+
+ReplayStats stats[MAX_CAPSENSE_CHANNELS];
+
+byte touching = NO_CAPSENSE_BUTTONS;
+byte detected = false;
+unsigned long readings = 0;
+unsigned long touchStart = 0;
+unsigned long binChanges = 0;
+
+#ifdef CS_IDLE_TICKS
+byte touchedWhileIdle;
+unsigned long idleReadings = 0;
+unsigned long idleTouches = 0;
+unsigned long idleDetected = 0;
+unsigned long idleLatencySum = 0;
+unsigned long idleLatencyMax = 0;
+#endif
+
+#ifdef CS_AUTO_CALIBRATE
+byte calibrating = false;
+unsigned long calibrationStart;
+CSAutoCalibrateState lastState;
+byte lastCalButton;
+#endif
+
+// The button the model is touching.
+byte ModelTouching(void)
+{
+	#ifdef CS_AUTO_CALIBRATE
+	if (calibrating) {
+		// A tap in the middle of the time it's asked for, so the readings have settled on both sides.
+		byte elapsed = ticks - ticksStateStart;
+		if (csAutoCalibrateState == acPressAndReleaseButton && elapsed >= 1 && elapsed < SETTLE_TICKS)
+			return csCalButton;
+		return NO_CAPSENSE_BUTTONS;
+	}
+	#endif
+	return touching;
+}
+
+#ifdef CS_AUTO_CALIBRATE
+// Runs the calibration along with the readings, and reports on it.
+void ReplayCalibration(void)
+{
+	byte done = !CapSenseContinueCalibrate();
+	
+	if (csAutoCalibrateState != lastState || csCalButton != lastCalButton) {
+		printf("# reading %lu: calibration state %d, button %d\n", readings, csAutoCalibrateState, csCalButton);
+		lastState = csAutoCalibrateState;
+		lastCalButton = csCalButton;
+	}
+	
+	csDomain = csAutoCalibrateState == acDomainBaselines;
+	
+	if (done) {
+		int i;
+		calibrating = false;
+		printf("calibrated in %lu readings; thresholds", readings - calibrationStart);
+		for (i = 0; i < (int) sizeof(csThresholds); i++)
+			printf(" %d", csThresholds[i]);
+		printf("; results (0 fail, 1 OK, 2 great)");
+		for (i = 0; i < MAX_CAPSENSE_CHANNELS; i++)
+			if (IsChannelUsed(i))
+				printf(" %d", csResults[i]);
+		printf("\n");
+	}
+}
+#endif
+
+// Runs one reading from the current channel through the ISR's code, and checks for a button.
+void ReplayReading(CapSenseReading value)
+{
+	// Same as UiTimeInterrupt().
+	if (++tickScaler == 0)
+		ticks++;
+	
+	#ifdef CS_IDLE_TICKS
+	if (csIdle)
+		idleReadings++;
+	#endif
+	
+	byte bin = csCurrentBin;
+	ProcessCapSenseReading(value);
+	readings++;
+	if (csCurrentBin != bin)
+		binChanges++;
+		
+	#ifdef CS_AUTO_CALIBRATE
+	if (calibrating) {
+		// The calibration takes the buttons.
+		ReplayCalibration();
+		return;
+	}
+	#endif
+	
+	byte button = GetCapSenseButton();
+	if (button != NO_CAPSENSE_BUTTONS) {
+		if (button == touching && !detected) {
+			unsigned long latency = readings - touchStart;
+			detected = true;
+			stats[button].detected++;
+			stats[button].latencySum += latency;
+			if (latency > stats[button].latencyMax)
+				stats[button].latencyMax = latency;
+				
+			#ifdef CS_IDLE_TICKS
+			if (touchedWhileIdle) {
+				idleDetected++;
+				idleLatencySum += latency;
+				if (latency > idleLatencyMax)
+					idleLatencyMax = latency;
+			}
+			#endif
+		} else if (button != touching)
+			stats[button].falsePositives++;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	InitCapSense();
+	
+	int i;
+	for (i = 1; i < argc && i <= (int) sizeof(csThresholds); i++)
+		csThresholds[i - 1] = (byte) atoi(argv[i]);
+	CapSenseThresholdsChanged();
+		
+	char line[120];
+	while (fgets(line, sizeof(line), stdin)) {
+		int channel, value;
+		
+		if (line[0] == 'd' && sscanf(line + 1, "%d", &channel) == 1 && channel < MAX_CAPSENSE_CHANNELS) {
+			touching = channel;
+			touchStart = readings;
+			detected = false;
+			stats[channel].touches++;
+			#ifdef CS_IDLE_TICKS
+			touchedWhileIdle = csIdle;
+			if (csIdle)
+				idleTouches++;
+			#endif
+		} else if (line[0] == 'u') {
+			touching = NO_CAPSENSE_BUTTONS;
+		} else if (line[0] == 'D' && sscanf(line + 1, "%d", &value) == 1) {
+			csDomain = value;
+		} else if (line[0] == 'm') {
+			unsigned long n;
+			int base, noise, depth;
+			if (sscanf(line + 1, "%lu %d %d %d", &n, &base, &noise, &depth) == 4)
+				while (n--) {
+					int reading = base + rand() % (2 * noise + 1) - noise;
+					if (currentCapSenseChannel == ModelTouching())
+						reading -= depth;
+					ReplayReading((CapSenseReading) reading);
+				}
+		#ifdef CS_AUTO_CALIBRATE
+		} else if (line[0] == 'c' || line[0] == 'C') {
+			if (line[0] == 'C')
+				CapSenseStartFastCalibrate();
+			else
+				CapSenseStartCalibrate();
+			calibrating = true;
+			calibrationStart = readings;
+			lastState = acDone;
+		#endif
+		} else if (line[0] == 'f') {
+			CapSenseReading frame[MAX_CAPSENSE_CHANNELS];
+			char* p = line + 1;
+			for (channel = 0; channel < MAX_CAPSENSE_CHANNELS; channel++)
+				frame[channel] = (CapSenseReading) strtol(p, &p, 10);
+			ReplayReading(frame[currentCapSenseChannel]);
+		} else if (sscanf(line, "%d %d", &channel, &value) == 2 && channel < MAX_CAPSENSE_CHANNELS) {
+			// Follow the trace's channel, in case readings were dropped.
+			currentCapSenseChannel = channel;
+			ReplayReading((CapSenseReading) value);
+		}
+	}
+	
+	printf("%lu readings, %lu bin changes\n", readings, binChanges);
+	printf("channel  touches  detected  missed  false+  latency avg  max\n");
+	for (i = 0; i < MAX_CAPSENSE_CHANNELS; i++) {
+		ReplayStats* s = &stats[i];
+		if (!IsChannelUsed(i))
+			continue;
+		printf("%7d  %7lu  %8lu  %6lu  %6lu  %11.1f  %3lu\n", i, s->touches, s->detected,
+			s->touches - s->detected, s->falsePositives,
+			s->detected ? (double) s->latencySum / s->detected : 0.0, s->latencyMax);
+	}
+	
+	#ifdef CS_IDLE_TICKS
+	printf("idle for %lu readings (%.1f%%); %lu touches began idle, %lu detected, latency avg %.1f max %lu\n",
+		idleReadings, readings ? 100.0 * idleReadings / readings : 0.0, idleTouches, idleDetected,
+		idleDetected ? (double) idleLatencySum / idleDetected : 0.0, idleLatencyMax);
+	#endif
+	
+	return 0;
+}
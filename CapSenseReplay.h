@@ -0,0 +1,75 @@
+/* CapSenseReplay.h
+    Copyright (c) 2026 by Timothy J. Weber, tw@timothyweber.org.
+
+	Stand-ins for the compiler built-ins and registers that CapSense.c uses,
+	so it can be built on a PC by CapSenseReplay.c.  CapSense.c includes this
+	instead of system.h when CS_REPLAY is defined.
+*/
+
+#ifndef _CAPSENSE_REPLAY_H
+#define _CAPSENSE_REPLAY_H
+
+#include <stdio.h>
+#include <string.h>
+
+// After the standard headers, which can undefine these.
+#include <stdlib.h>
+#include "crc_8bit.h"
+#define min(a, b)  ((a) < (b) ? (a) : (b))
+#define max(a, b)  ((a) > (b) ? (a) : (b))
+#define clear_wdt()
+
+typedef unsigned char bit;
+
+// The registers that are still touched with the hardware set-up compiled out.
+struct { unsigned char T0IF, GIE; } intcon;
+struct { unsigned char EEIF; } pir2;
+unsigned char tmr1l, tmr1h;
+
+// From uiTime; the replay advances these once per reading, the way UiTimeInterrupt() does.
+unsigned char ticks;
+unsigned char tickScaler;
+
+// EEPROM starts out blank, so the thresholds start at their defaults; the replay sets them itself.
+unsigned char eeprom[256];
+
+char read_eeprom(char addr)
+{
+	return eeprom[(unsigned char) addr];
+}
+
+void write_eeprom(char addr, char data)
+{
+	eeprom[(unsigned char) addr] = data;
+}
+
+void read_eeprom_block(char addr, char* buf, unsigned char len)
+{
+	while (len--)
+		*buf++ = read_eeprom(addr++);
+}
+
+void write_eeprom_block(char addr, char* buf, unsigned char len)
+{
+	while (len--)
+		write_eeprom(addr++, *buf++);
+}
+
+// The same CRC as crc_8bit.c, a bit at a time.
+unsigned char crc8Block(Crc8Context* ctx, unsigned char* buf, unsigned char len)
+{
+	unsigned char c = ctx->crc;
+	unsigned char i;
+	
+	while (len--) {
+		c ^= *buf++;
+		for (i = 0; i < 8; i++)
+			c = (c & 1) ? (c >> 1) ^ 0x8C : c >> 1;
+	}
+	
+	ctx->crc = c;
+	return c;
+}
+
+#endif
+// _CAPSENSE_REPLAY_H
@@ -32,33 +32,58 @@
 
 unsigned char DT_CountSensors(byte bus)
 {
-	// For now, assume we have at most one sensor connected.
-	if (OWB_Reset(bus))
-		return 1;
-	else
-		return 0;
+	OWSearch search;
+	unsigned char count = 0;
+	byte found;
+	
+	for (found = OWB_SearchFirst(bus, &search, DT_FAMILY); found; found = OWB_SearchNext(bus, &search))
+		++count;
+		
+	return count;
+}
+
+byte DT_FindSensors(byte bus, byte* roms, byte maxSensors)
+{
+	OWSearch search;
+	byte count = 0;
+	byte found = OWB_SearchFirst(bus, &search, DT_FAMILY);
+	byte i;
+	
+	while (found && count < maxSensors) {
+		for (i = 0; i < OW_ROM_LEN; i++)
+			*roms++ = search.rom[i];
+		++count;
+		
+		found = OWB_SearchNext(bus, &search);
+	}
+	
+	return count;
 }
 
-byte DT_IsParasite(byte bus)
+// rom is 0 for all sensors on the bus, as in the rest of this file.
+byte DT_IsParasite(byte bus, byte* rom)
 {
+	OWB_Select(bus, rom);
+	
 	if (bus) {
-		OW_SendByte_2(OW_SkipROM);
 		OW_SendByte_2(DT_ReadPowerSupply);
 		return !OW_ReadBit_2();  // parasite-powered devices pull the bus low.
 	} else {
-		OW_SendByte(OW_SkipROM);
 		OW_SendByte(DT_ReadPowerSupply);
 		return !OW_ReadBit();  // parasite-powered devices pull the bus low.
 	}
 }
 
-void StartRead(byte bus, unsigned char configReg)
+void StartRead(byte bus, byte* rom, unsigned char configReg)
 {
-	byte useParasite = DT_IsParasite(bus);
+	byte useParasite = DT_IsParasite(bus, rom);
+	
+	// That was a whole transaction; the sensors wait for a reset before the next one.
+	OWB_Reset(bus);
 	
 	if (bus) {
-		// Talk to whoever's attached (assuming one).
-		OW_SendByte_2(OW_SkipROM);
+		// Talk to the sensor, or to whoever's attached.
+		OWB_Select(bus, rom);
 		
 		// Configure for low resolution.
 		OW_SendByte_2(DT_WriteScratchPad);
@@ -69,15 +94,15 @@ void StartRead(byte bus, unsigned char configReg)
 		OW_Reset_2();  // Don't need to write anything else.
 		
 		// Start temperature conversion.
-		OW_SendByte_2(OW_SkipROM);
+		OWB_Select(bus, rom);
 		OW_SendByte_2(DT_ConvertT);
 		
 		// Support parasite power.
 		if (useParasite) 
 			OW_PowerOn_2();
 	} else {
-		// Talk to whoever's attached (assuming one).
-		OW_SendByte(OW_SkipROM);
+		// Talk to the sensor, or to whoever's attached.
+		OWB_Select(bus, rom);
 		
 		// Configure for low resolution.
 		OW_SendByte(DT_WriteScratchPad);
@@ -88,7 +113,7 @@ void StartRead(byte bus, unsigned char configReg)
 		OW_Reset();  // Don't need to write anything else.
 		
 		// Start temperature conversion.
-		OW_SendByte(OW_SkipROM);
+		OWB_Select(bus, rom);
 		OW_SendByte(DT_ConvertT);
 		
 		// Support parasite power.
@@ -97,9 +122,9 @@ void StartRead(byte bus, unsigned char configReg)
 	}
 }
 
-signed short DoRead(byte bus, unsigned char configReg, unsigned short conversionTime)
+signed short DoRead(byte bus, byte* rom, unsigned char configReg, unsigned short conversionTime)
 {
-	StartRead(bus, configReg);
+	StartRead(bus, rom, configReg);
 	
 	// Wait for it to finish.
 	while (conversionTime > 255) {
@@ -108,10 +133,15 @@ signed short DoRead(byte bus, unsigned char configReg, unsigned short conversion
 	}
 	delay_ms((unsigned char)(conversionTime));
 	
-	return DT_GetLastTemp(0);
+	return DT_GetLastTempROM(bus, rom);
 }
 
 signed char DT_ReadTempRough(byte bus)
+{
+	return DT_ReadTempRoughROM(bus, 0);
+}
+
+signed char DT_ReadTempRoughROM(byte bus, byte* rom)
 {
 	// The bus can only be 0 or 1.
 	if (bus > 1)
@@ -121,7 +151,7 @@ signed char DT_ReadTempRough(byte bus)
 	if (!OWB_Reset(bus))
 		return 0;
 		
-	short value = DoRead(bus, 
+	short value = DoRead(bus, rom, 
 		(BitsToSense_LowRes - 9) << DT_ConfigResOffset, 
 		ConversionTime_LowRes);
 
@@ -140,23 +170,33 @@ signed char DT_ReadTempRough(byte bus)
 }
 
 signed short DT_ReadTempFine(byte bus)
+{
+	return DT_ReadTempFineROM(bus, 0);
+}
+
+signed short DT_ReadTempFineROM(byte bus, byte* rom)
 {
 	// The bus can only be 0 or 1, and it must have something on it.
 	if (bus > 1 || !OWB_Reset(bus))
 		return 0;
 	else 
-		return DoRead(bus, 
+		return DoRead(bus, rom, 
 			(BitsToSense_HighRes - 9) << DT_ConfigResOffset, 
 			ConversionTime_HighRes);
 }
 
 unsigned char DT_StartReadFine(byte bus)
+{
+	return DT_StartReadFineROM(bus, 0);
+}
+
+unsigned char DT_StartReadFineROM(byte bus, byte* rom)
 {
 	// The bus can only be 0 or 1, and it must have something on it.
 	if (bus > 1 || !OWB_Reset(bus))
 		return 0;
 	else { 
-		StartRead(bus, (BitsToSense_HighRes - 9) << DT_ConfigResOffset);
+		StartRead(bus, rom, (BitsToSense_HighRes - 9) << DT_ConfigResOffset);
 		return 1;
 	}
 }
@@ -167,118 +207,71 @@ unsigned char DT_ReadDone(byte bus)
 }
 
 fixed16 DT_GetLastTemp(byte bus)
+{
+	return DT_GetLastTempROM(bus, 0);
+}
+
+fixed16 DT_GetLastTempROM(byte bus, byte* rom)
 {
 	// Read the temperature value.
 	if (!OWB_Reset(bus))
 		return DT_BAD_TEMPERATURE;
 
-	unsigned char lsb;
-	signed char msb;
-		
-	byte b;
+	// The whole scratchpad: temperature LSB and MSB, user bytes, configuration,
+	// reserved bytes, and the CRC of the preceding 8 bytes at @8.
+	unsigned char scratch[9];
+	byte i;
 
 	if (bus) {
 		// Bus #2.
-		OW_SendByte_2(OW_SkipROM);
+		OWB_Select(bus, rom);
 		OW_SendByte_2(DT_ReadScratchPad);
 		
-		lsb = OW_ReadByte_2();
-		msb = OW_ReadByte_2();
-		
-	// Check CRC.
+		for (i = 0; i < sizeof(scratch); i++)
+			scratch[i] = OW_ReadByte_2();
+	} else {
+		// Bus #1.
+		OWB_Select(bus, rom);
+		OW_SendByte(DT_ReadScratchPad);
 		
-		// Start with what we've already read.
-		crc8Init();
-		crc8(lsb);
-		crc8(msb);
+		for (i = 0; i < sizeof(scratch); i++)
+			scratch[i] = OW_ReadByte();
+	}
 	
-		// Read and include the next 6 bytes.
-		
+	// @4 = Configuration, 0x1F bits should be on.
+	if ((scratch[4] & 0x1F) != 0x1F)
 		#ifdef TEMP_DIAGS
-			// @2-3 = user byte, doesn't matter
-			crc8(OW_ReadByte_2());
-			crc8(OW_ReadByte_2());
-			
-			// @4 = Configuration, 0x1F bits should be on.
-			b = OW_ReadByte_2();
-			crc8(b);
-			
-			if ((b & 0x1F) != 0x1F)
-				return 0x0A00;  // = 50 F
-			
-			// @5 = Reserved (0xFF)
-			b = OW_ReadByte_2();
-			crc8(b);
-			
-			if (b != 0xFF)
-				return 0x0480;  // = 40 F
-			
-			// @6 = Reserved (0xOC, but apparently varies)
-			b = OW_ReadByte_2();
-			crc8(b);
-			
-			// @7 = Reserved (0x10)
-			b = OW_ReadByte_2();
-			crc8(b);
-			
-			if (b != 0x10)
-				return 0x0CC;  // = 55 F
+			return 0x0A00;  // = 50 F
 		#else
-			crc8(OW_ReadByte_2());
-			crc8(OW_ReadByte_2());
-
-			// @4 = Configuration, 0x1F bits should be on.
-			b = OW_ReadByte_2();
-			if ((b & 0x1F) != 0x1F)
-				return DT_BAD_TEMPERATURE;
-			crc8(b);
-
-			crc8(OW_ReadByte_2());
-			crc8(OW_ReadByte_2());
-			crc8(OW_ReadByte_2());
+			return DT_BAD_TEMPERATURE;
 		#endif
-			
-		// Byte @8 is the CRC itself.
-		if (OW_ReadByte_2() != crc)
-			// Didn't pass the test.
-			#ifdef TEMP_DIAGS
-				return 0x2300;  // = 95 F
-			#else
-				return DT_BAD_TEMPERATURE;
-			#endif
-	} else {
-		// Bus #1.
-		OW_SendByte(OW_SkipROM);
-		OW_SendByte(DT_ReadScratchPad);
+	
+	#ifdef TEMP_DIAGS
+		// @5 = Reserved (0xFF)
+		if (scratch[5] != 0xFF)
+			return 0x0480;  // = 40 F
 		
-		lsb = OW_ReadByte();
-		msb = OW_ReadByte();
-
-	// Check CRC.
+		// @6 = Reserved (0xOC, but apparently varies)
 		
-		// Start with what we've already read.
-		crc8Init();
-		crc8(lsb);
-		crc8(msb);
+		// @7 = Reserved (0x10)
+		if (scratch[7] != 0x10)
+			return 0x0CC;  // = 55 F
+	#endif
 	
-		crc8(OW_ReadByte());
-		crc8(OW_ReadByte());
-
-		// @4 = Configuration, 0x1F bits should be on.
-		b = OW_ReadByte();
-		if ((b & 0x1F) != 0x1F)
-			return DT_BAD_TEMPERATURE;
-		crc8(b);
-
-		crc8(OW_ReadByte());
-		crc8(OW_ReadByte());
-		crc8(OW_ReadByte());
-			
-		// Byte @8 is the CRC itself.
-		if (OW_ReadByte() != crc)
-			// Didn't pass the test.
+	// Check CRC.
+	// Including the CRC byte itself, the result is 0 if the data is good.
+	Crc8Context ctx;
+	crc8InitContext(&ctx);
+	if (crc8Block(&ctx, scratch, sizeof(scratch)) != 0)
+		// Didn't pass the test.
+		#ifdef TEMP_DIAGS
+			return 0x2300;  // = 95 F
+		#else
 			return DT_BAD_TEMPERATURE;
-	}
+		#endif
+		
+	unsigned char lsb = scratch[0];
+	signed char msb = scratch[1];
 		
 	// Adjust to a sane representation.
 	fixed16 result = makeFixed(msb, lsb);
@@ -14,8 +14,10 @@
 	Supports both busses supported by the onewire module.
 	Bus number can be either 0 or 1.
 	
-	Only a single sensor is supported on each bus at the moment -
-	that is, reading is done in "SKIP ROM" (global reply) mode.
+	Any number of sensors can share a bus.  Find them with DT_FindSensors(), and read each one
+	with the *ROM functions, which address it by its ROM code.  The functions without ROM
+	talk to every sensor on the bus at once ("SKIP ROM" mode), so they're only good for a bus
+	with one sensor - except DT_StartReadFine(), which is the quickest way to start all of them.
 	
 	A requirement inherited from the onewire module:
 	To maintain timing requirements, interrupts are disabled during bus reads and writes,
@@ -40,9 +42,17 @@
 #define DT_BAD_TEMPERATURE  ((short) DT_BAD_TEMPERATURE_VAL)
 
 
+// The family code of the DS18B20, the first byte of its ROM code.
+#define DT_FAMILY  0x28
+
 // Returns the number of sensors connected to the specified bus.
+// Searches the bus, so it takes about 13 ms per sensor.
 unsigned char DT_CountSensors(byte bus);
 
+// Puts the ROM codes of up to maxSensors sensors on the bus into roms, 8 (OW_ROM_LEN) bytes apiece,
+// and returns how many it found.  They come out in the same order every time.
+byte DT_FindSensors(byte bus, byte* roms, byte maxSensors);
+
 // Synchronous reading:
 
 // Reads the temperature to the nearest degree,
@@ -51,6 +61,7 @@ unsigned char DT_CountSensors(byte bus);
 // If the specified bus has no slave devices on it, the minimum temperature is returned.
 // Takes about 96 ms.
 signed char DT_ReadTempRough(byte bus);
+signed char DT_ReadTempRoughROM(byte bus, byte* rom);
 
 // Reads the temperature to the highest resolution possible,
 // and returns it as 16-bit fixed point (8 bits integer, 8 bits fractional).
@@ -58,15 +69,22 @@ signed char DT_ReadTempRough(byte bus);
 // If the specified bus has no slave devices on it, the minimum temperature is returned.
 // Takes about 750 ms.
 signed short DT_ReadTempFine(byte bus);
+signed short DT_ReadTempFineROM(byte bus, byte* rom);
 
 // Asynchronous reading:
 
 // Starts temperature conversion on the given bus.
 // No other 1-Wire commands should be done on the bus until DT_ReadDone returns true.
+// This starts every sensor on the bus, so they all convert in the time it takes one;
+// then get each one's result with DT_GetLastTempROM().
 unsigned char DT_StartReadFine(byte bus);
 
+// Starts temperature conversion on just the sensor with the given ROM code.
+unsigned char DT_StartReadFineROM(byte bus, byte* rom);
+
 // Returns true if the conversion has finished.
 unsigned char DT_ReadDone(byte bus);
 
 // Returns the result of the last temperature conversion on the given bus.
 fixed16 DT_GetLastTemp(byte bus);
+fixed16 DT_GetLastTempROM(byte bus, byte* rom);
@@ -0,0 +1,204 @@
+/* SerialSim.c
+    Copyright (c) 2026 by Timothy J. Weber, tw@timothyweber.org.
+
+	Checks the SOFTWARE_RECEIVE receiver in serial.c on a PC, one instruction cycle at a time.
+	A simulated sender transmits random bytes at the configured baud rate, off by up to 3%
+	either way, with random gaps and occasional glitches between bytes; Timer2, the
+	interrupt-on-change flag and the interrupt latency are modeled around the unchanged
+	SerialInterrupt(), and every byte has to come out of ReadSerial() as it was sent.
+
+	Build with a PC's C++ compiler, with the project's serial-consts.h on the include path,
+	and the clock and baud rate to check (the defaults are the same as serial.c's):
+		g++ -x c++ -funsigned-char -DSERIAL_SIM -DSOFT_RX_CLOCK_FREQ=4000000 -DSOFT_RX_BAUD_RATE=9600 \
+			-I <project> -I <this library> SerialSim.c -o serialsim
+	and run it with the number of bytes to send at each rate, the most extra latency (in cycles)
+	to add at random to each interrupt, and how many cycles the ISR takes after sampling:
+		serialsim 2000 4 30
+	It prints the results for each sender rate, and exits with 1 if any byte was lost or garbled.
+	Pairs that serial.c can't time well enough don't build; that's checked at compile time.
+*/
+
+#include "serial.c"
+
+// The sender's timing, in instruction cycles.
+double senderBitCycles;
+
+// The bytes to send, and when each one's start bit begins.
+#define MAX_SIM_BYTES  10000
+unsigned char sent[MAX_SIM_BYTES];
+double sentStart[MAX_SIM_BYTES];
+unsigned int sentCount;
+
+// A glitch: the line goes low briefly, this long after the stop bit of the byte with the same index.
+double glitchAfter[MAX_SIM_BYTES];
+#define GLITCH_CYCLES  3
+
+// When SerialInterrupt() next reads the pin, and the level it last read.
+// Each read after the first comes this many cycles later, as the ISR goes on.
+double pinReadAt;
+bit pinLastRead;
+#define PIN_REREAD_CYCLES  6
+
+bit LineAt(double t);
+
+bit SimReadPin()
+{
+	pinLastRead = LineAt(pinReadAt);
+	pinReadAt += PIN_REREAD_CYCLES;
+	return pinLastRead;
+}
+
+// Returns the line's level at time t, moving forward through the bytes.
+unsigned int lineByte = 0;
+bit LineAt(double t)
+{
+	while (lineByte < sentCount && t >= sentStart[lineByte] + 10 * senderBitCycles)
+		lineByte++;
+		
+	if (lineByte > 0) {
+		// Between bytes; maybe a glitch.
+		double glitch = sentStart[lineByte - 1] + 10 * senderBitCycles + glitchAfter[lineByte - 1];
+		if (glitchAfter[lineByte - 1] > 0 && t >= glitch && t < glitch + GLITCH_CYCLES)
+			return 0;
+	}
+	
+	if (lineByte == sentCount || t < sentStart[lineByte])
+		// Idle.
+		return 1;
+		
+	int bitIndex = (int) ((t - sentStart[lineByte]) / senderBitCycles);
+	if (bitIndex == 0)
+		return 0;  // start bit
+	else if (bitIndex <= 8)
+		return (sent[lineByte] >> (bitIndex - 1)) & 1;
+	else
+		return 1;  // stop bit
+}
+
+// Sends count random bytes with the sender's clock off by rateError (0.03 = 3% fast),
+// and returns the number that didn't come through.
+unsigned int Run(unsigned int count, double rateError, int jitter, int isrCycles)
+{
+	unsigned int i;
+	double t = 100;
+	
+	senderBitCycles = SOFT_RX_CLOCK_FREQ / 4.0 / SOFT_RX_BAUD_RATE / (1 + rateError);
+	sentCount = count;
+	for (i = 0; i < count; i++) {
+		sent[i] = rand();
+		sentStart[i] = t;
+		t += 10 * senderBitCycles;
+		
+		// A gap of up to 3 bits, with a glitch in the middle of every eighth one that's long enough.
+		double gap = (rand() % 4) * senderBitCycles;
+		glitchAfter[i] = (rand() % 8 == 0 && gap > 0) ? gap / 2 : 0;
+		t += gap;
+	}
+	lineByte = 0;
+	pinReadAt = 0;
+	
+	InitializeSerial();
+	
+	unsigned char received[MAX_SIM_BYTES];
+	unsigned int receivedCount = 0;
+	bit latch = 1;  // the level last read from the port, for interrupt-on-change
+	long latchedAt = 0;  // when it was read; the ISR clears RBIF right after
+	unsigned int prescaleCount = 0;
+	long isrAt = -1;  // when the pending interrupt samples the pin
+	long busyUntil = 0;
+	long cycle;
+	long end = (long) t + 20 * (long) senderBitCycles;
+	
+	for (cycle = 0; cycle < end; cycle++) {
+		bit line = LineAt(cycle);
+		if (line != latch && cycle > latchedAt)
+			intcon.RBIF = 1;
+			
+		// Timer2 resets on the tick after it matches PR2, and that sets TMR2IF.
+		if (t2con.TMR2ON && ++prescaleCount >= T2_PRESCALE) {
+			prescaleCount = 0;
+			if (tmr2 == pr2) {
+				tmr2 = 0;
+				pir1.TMR2IF = 1;
+			} else
+				tmr2++;
+		}
+		
+		if (isrAt < 0 && cycle >= busyUntil && intcon.GIE
+			&& ((pir1.TMR2IF && pie1.TMR2IE) || (intcon.RBIF && intcon.RBIE)))
+			isrAt = cycle + SOFT_RX_LATENCY + (jitter ? rand() % (jitter + 1) : 0);
+			
+		if (cycle == isrAt) {
+			bit wasOn = t2con.TMR2ON;
+			
+			// Every path through SerialInterrupt() reads the port, which ends a mismatch.
+			pinReadAt = cycle;
+			SerialInterrupt();
+			
+			// Interrupt-on-change compares against the last read, from then on.
+			latch = pinLastRead;
+			latchedAt = (long) pinReadAt - PIN_REREAD_CYCLES;
+			
+			// Writing TMR2 clears the prescaler.
+			if (!wasOn && t2con.TMR2ON)
+				prescaleCount = 0;
+				
+			isrAt = -1;
+			busyUntil = cycle + isrCycles;
+			
+			// A main loop that keeps up.
+			while (ser_hasData)
+				received[receivedCount++] = ReadSerial();
+		}
+	}
+	
+	// Count the bytes that were garbled, lost or made up, lining the two streams back up after each one
+	// so a single lost byte doesn't count against everything after it.
+	unsigned int bad = 0;
+	unsigned int j = 0;
+	i = 0;
+	while (i < count || j < receivedCount) {
+		if (i < count && j < receivedCount && received[j] == sent[i]) {
+			i++;
+			j++;
+			continue;
+		}
+		
+		bad++;
+		if (i + 1 < count && j < receivedCount && received[j] == sent[i + 1])
+			i++;  // lost
+		else if (j + 1 < receivedCount && i < count && received[j + 1] == sent[i])
+			j++;  // made up
+		else {
+			// garbled, or past the end of one of them
+			if (i < count)
+				i++;
+			if (j < receivedCount)
+				j++;
+		}
+	}
+	return bad;
+}
+
+int main(int argc, char* argv[])
+{
+	unsigned int count = argc > 1 ? atoi(argv[1]) : 2000;
+	int jitter = argc > 2 ? atoi(argv[2]) : 4;
+	int isrCycles = argc > 3 ? atoi(argv[3]) : 30;
+	int percent;
+	unsigned int totalBad = 0;
+	
+	if (count > MAX_SIM_BYTES)
+		count = MAX_SIM_BYTES;
+		
+	printf("%d Hz, %d baud: %d cycles per bit, Timer2 prescale %d, start wait %d ticks, bit period %d ticks\n",
+		SOFT_RX_CLOCK_FREQ, SOFT_RX_BAUD_RATE, BIT_CYCLES, T2_PRESCALE, START_TICKS, BIT_TICKS);
+	printf("sender rate  bytes  bad  framing errors\n");
+	for (percent = -30; percent <= 30; percent += 5) {
+		unsigned int bad = Run(count, percent / 1000.0, jitter, isrCycles);
+		printf("%+10.1f%%  %5u  %3u  %14u\n", percent / 10.0, count, bad, ser_framingErrors);
+		totalBad += bad;
+	}
+	
+	return totalBad ? 1 : 0;
+}
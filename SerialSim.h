@@ -0,0 +1,52 @@
+/* SerialSim.h
+    Copyright (c) 2026 by Timothy J. Weber, tw@timothyweber.org.
+
+	Stand-ins for the compiler built-ins and registers that serial.c uses,
+	so its software receiver can be built on a PC by SerialSim.c.  serial.c includes this
+	instead of system.h when SERIAL_SIM is defined.
+*/
+
+#ifndef _SERIAL_SIM_H
+#define _SERIAL_SIM_H
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// Only the software receiver is simulated.
+#define SOFTWARE_RECEIVE
+
+typedef unsigned char bit;
+
+// The registers; SerialSim.c plays the part of the hardware behind them.
+struct { unsigned char GIE, PEIE, RBIF, RBIE; } intcon;
+struct { unsigned char TMR2IF, TXIF, RCIF; } pir1;
+struct { unsigned char TMR2IE, RCIE; } pie1;
+struct { unsigned char BRGH, TXEN; } txsta;
+struct { unsigned char SPEN, CREN, FERR, OERR; } rcsta;
+unsigned char pr2, tmr2, txreg, rcreg, spbrg;
+
+// T2CON is written whole, for the prescaler, and by its TMR2ON bit.
+struct T2con {
+	unsigned char TMR2ON;
+	unsigned char T2CKPS;
+	
+	T2con& operator=(unsigned char value)
+	{
+		T2CKPS = value & 0x03;
+		TMR2ON = (value >> 2) & 1;
+		return *this;
+	}
+} t2con;
+
+// The receive pin, and PORTB.  Each read gets the line's level from SerialSim.c, a little later
+// than the one before, since SerialInterrupt() reads them again at the end to re-arm interrupt-on-change.
+bit SimReadPin();
+struct ReceivePin {
+	operator bit() const  { return SimReadPin(); }
+} receiveBit;
+struct PortB {
+	operator unsigned char() const  { return SimReadPin() ? 0xFF : 0x00; }  // only the read matters
+} portb;
+
+#endif
+// _SERIAL_SIM_H
@@ -80,4 +80,26 @@ byte GetButton(void)
 	#endif
 	
 	return NO_BTN;
-}
\ No newline at end of file
+}
+
+
+#ifdef TEST_BUTTONS
+void main(void)
+{
+	// Time this with the simulator's stopwatch, from one breakpoint to the next.
+	// Every mask takes the same time per button, whichever bits are set.
+	unsigned short mask;
+	byte pending, btn;
+	for (mask = 0; mask < 256; mask++) {
+		pending = (byte) mask;
+		while (pending)
+			btn = clearLowestSetBit<byte>(pending, 7);
+	}
+	
+	// bitCount(0xB5) = 5
+	btn = bitCount(0xB5);
+	
+	// lowestSetBitIndex(0x28) = 3
+	btn = lowestSetBitIndex<byte>(0x28);
+}
+#endif
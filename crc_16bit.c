@@ -0,0 +1,180 @@
+/* crc_16bit.c
+    Copyright (c) 2026 by Timothy J. Weber, tw@timothyweber.org.
+
+	CRC-16 for Dallas/Maxim 1-Wire products.
+	
+	Like crc_8bit.c, the table and nibble arrays are generated from the CRCs
+	of the eight single-bit bytes.  The 16-bit entries are kept as separate
+	low and high byte arrays, since ROM arrays are bytes.
+	
+	Define TEST_CRC_16BIT to build a main() that checks the results and
+	times each implementation with the SourceBoost simulator's stopwatch.
+*/
+
+#include <system.h>
+
+#define IN_CRC_16BIT
+
+#include "crc_16bit.h"
+
+
+// Choose your favorite implementation by defining (only) one of these macros.
+#if !defined(CRC16_IMP_TABLE) && !defined(CRC16_IMP_NIBBLES) && !defined(CRC16_IMP_BITS)
+ #define CRC16_IMP_BITS
+#endif
+
+
+// The CRC of each byte with a single bit set.
+// The CRC is linear, so the CRC of any byte is the XOR of these for each of its bits.
+#define CRC16_BIT0  0xc0c1
+#define CRC16_BIT1  0xc181
+#define CRC16_BIT2  0xc301
+#define CRC16_BIT3  0xc601
+#define CRC16_BIT4  0xcc01
+#define CRC16_BIT5  0xd801
+#define CRC16_BIT6  0xf001
+#define CRC16_BIT7  0xa001
+
+// The CRC of the constant byte i, evaluated at compile time.
+#define CRC16_OF(i)  ( \
+	(((i) & 0x01) ? CRC16_BIT0 : 0) ^ (((i) & 0x02) ? CRC16_BIT1 : 0) ^ \
+	(((i) & 0x04) ? CRC16_BIT2 : 0) ^ (((i) & 0x08) ? CRC16_BIT3 : 0) ^ \
+	(((i) & 0x10) ? CRC16_BIT4 : 0) ^ (((i) & 0x20) ? CRC16_BIT5 : 0) ^ \
+	(((i) & 0x40) ? CRC16_BIT6 : 0) ^ (((i) & 0x80) ? CRC16_BIT7 : 0))
+
+#define CRC16_LO(i)  (CRC16_OF(i) & 0xFF)
+#define CRC16_HI(i)  (CRC16_OF(i) >> 8)
+
+// Eight consecutive low or high bytes of table entries, starting at i.
+#define CRC16_LO_ROW(i)  \
+	CRC16_LO(i), CRC16_LO((i) + 1), CRC16_LO((i) + 2), CRC16_LO((i) + 3), \
+	CRC16_LO((i) + 4), CRC16_LO((i) + 5), CRC16_LO((i) + 6), CRC16_LO((i) + 7)
+#define CRC16_HI_ROW(i)  \
+	CRC16_HI(i), CRC16_HI((i) + 1), CRC16_HI((i) + 2), CRC16_HI((i) + 3), \
+	CRC16_HI((i) + 4), CRC16_HI((i) + 5), CRC16_HI((i) + 6), CRC16_HI((i) + 7)
+
+// All 256 low or high bytes.
+#define CRC16_TABLE(ROW)  \
+	ROW(0x00), ROW(0x08), ROW(0x10), ROW(0x18), ROW(0x20), ROW(0x28), ROW(0x30), ROW(0x38), \
+	ROW(0x40), ROW(0x48), ROW(0x50), ROW(0x58), ROW(0x60), ROW(0x68), ROW(0x70), ROW(0x78), \
+	ROW(0x80), ROW(0x88), ROW(0x90), ROW(0x98), ROW(0xa0), ROW(0xa8), ROW(0xb0), ROW(0xb8), \
+	ROW(0xc0), ROW(0xc8), ROW(0xd0), ROW(0xd8), ROW(0xe0), ROW(0xe8), ROW(0xf0), ROW(0xf8)
+
+// The high nibble's entries.
+#define CRC16_NIBBLE_HI(BYTE)  \
+	BYTE(0x00), BYTE(0x10), BYTE(0x20), BYTE(0x30), BYTE(0x40), BYTE(0x50), BYTE(0x60), BYTE(0x70), \
+	BYTE(0x80), BYTE(0x90), BYTE(0xa0), BYTE(0xb0), BYTE(0xc0), BYTE(0xd0), BYTE(0xe0), BYTE(0xf0)
+
+
+#ifdef CRC16_IMP_TABLE
+
+rom char* crc16_lo = { CRC16_TABLE(CRC16_LO_ROW) };
+rom char* crc16_hi = { CRC16_TABLE(CRC16_HI_ROW) };
+
+// Returns the CRC c updated with the data byte.
+inline unsigned short crc16Step(unsigned short c, unsigned char data)
+{
+	unsigned char i = data ^ (unsigned char) c;
+	
+	return (c >> 8) ^ crc16_lo[i] ^ ((unsigned short) crc16_hi[i] << 8);
+}
+
+#endif
+
+#ifdef CRC16_IMP_NIBBLES
+
+// CRC arrays for the nibble-wise routine.
+rom char* r1_lo = { CRC16_LO_ROW(0x00), CRC16_LO_ROW(0x08) };
+rom char* r1_hi = { CRC16_HI_ROW(0x00), CRC16_HI_ROW(0x08) };
+rom char* r2_lo = { CRC16_NIBBLE_HI(CRC16_LO) };
+rom char* r2_hi = { CRC16_NIBBLE_HI(CRC16_HI) };
+
+inline unsigned short crc16Step(unsigned short c, unsigned char data)
+{
+	unsigned char i = data ^ (unsigned char) c;
+	unsigned char lo = i & 0xf;
+	unsigned char hi = i >> 4;
+	
+	return (c >> 8) ^ (r1_lo[lo] ^ r2_lo[hi]) ^ ((unsigned short) (r1_hi[lo] ^ r2_hi[hi]) << 8);
+}
+#endif
+
+#ifdef CRC16_IMP_BITS
+inline unsigned short crc16Step(unsigned short c, unsigned char data)
+{
+	unsigned char i = data ^ (unsigned char) c;
+	unsigned short result = c >> 8;
+	
+	if(i & 1)
+		result ^= CRC16_BIT0;
+	if(i & 2)
+		result ^= CRC16_BIT1;
+	if(i & 4)
+		result ^= CRC16_BIT2;
+	if(i & 8)
+		result ^= CRC16_BIT3;
+	if(i & 0x10)
+		result ^= CRC16_BIT4;
+	if(i & 0x20)
+		result ^= CRC16_BIT5;
+	if(i & 0x40)
+		result ^= CRC16_BIT6;
+	if(i & 0x80)
+		result ^= CRC16_BIT7;
+	
+	return result;
+}
+#endif
+
+unsigned short crc16(unsigned char data)
+{
+	crc16Value = crc16Step(crc16Value, data);
+	return crc16Value;
+}
+
+unsigned short crc16Block(Crc16Context* ctx, unsigned char* buf, unsigned char len)
+{
+	unsigned short c = ctx->crc;
+	
+	while (len--)
+		c = crc16Step(c, *buf++);
+		
+	ctx->crc = c;
+	return c;
+}
+
+#ifdef TEST_CRC_16BIT
+// Time these in the simulator, from one breakpoint to the next.
+unsigned char testBuf[64];
+
+void main(void)
+{
+	// The standard check string, followed by its inverted CRC, LSB first.
+	unsigned char check[12] = "123456789\xc2\x44";
+	Crc16Context ctx;
+	unsigned short c;
+	unsigned char i;
+	
+	// Should be 0xbb3d.
+	crc16InitContext(&ctx);
+	c = crc16Block(&ctx, check, 9);
+	
+	// Including the CRC, should be CRC16_GOOD_RESIDUE.
+	crc16InitContext(&ctx);
+	c = crc16Block(&ctx, check, 11);
+	
+	// The same, a byte at a time.
+	crc16Init();
+	for (i = 0; i < 11; i++)
+		crc16(check[i]);
+	c = crc16Value;
+	
+	// Cycles per byte, over a longer buffer.
+	for (i = 0; i < sizeof(testBuf); i++)
+		testBuf[i] = i * 37;
+	crc16InitContext(&ctx);
+	c = crc16Block(&ctx, testBuf, sizeof(testBuf));
+	
+	c = 0;
+}
+#endif
@@ -0,0 +1,63 @@
+/* crc_16bit.h
+    Copyright (c) 2026 by Timothy J. Weber, tw@timothyweber.org.
+
+	CRC-16 for Dallas/Maxim 1-Wire products, following the same pattern as crc_8bit.
+	
+	From Maxim/Dallas AP Note 27
+	
+	"Understanding and Using Cyclic Redundancy Checks with 
+	Dallas Semiconductor iButton Products"
+	
+	In the usual catalog terms, this is CRC-16/MAXIM: polynomial x^16 + x^15 + x^2 + 1
+	(0x8005, or 0xA001 bit-reversed), shifted in LSB first, starting at 0.
+	The devices send the inverted CRC, LSB first.
+	
+	The value kept here is not inverted, so to check a block, either compare the
+	inverse of the CRC to the two bytes received, or run those bytes through the CRC
+	along with the data and compare the result to CRC16_GOOD_RESIDUE.
+	
+	The CRC of the ASCII string "123456789" is 0xBB3D here (0x44C2 once inverted).
+	
+	Choose the implementation in crc_16bit.c by defining one of CRC16_IMP_TABLE (fastest, 512 bytes of ROM),
+	CRC16_IMP_NIBBLES (64 bytes of ROM), or CRC16_IMP_BITS (no table; the default).
+*/
+
+#ifndef __CRC_16BIT_H
+#define __CRC_16BIT_H
+
+#ifdef IN_CRC_16BIT
+ #define CRC_16BIT_EXTERN
+#else
+ #define CRC_16BIT_EXTERN  extern
+#endif
+
+
+// The CRC of a good block followed by its (inverted) CRC bytes.
+#define CRC16_GOOD_RESIDUE  0xB001
+
+// Holds the last-returned CRC.
+// Used as input to the next one.
+CRC_16BIT_EXTERN unsigned short crc16Value;
+
+// Call this before distinct runs of CRC values.
+inline void crc16Init(void)  { crc16Value = 0; }
+
+// Returns the CRC of the given byte, preceded by all bytes since crc16Init().
+unsigned short crc16(unsigned char data);
+
+// An explicit CRC state, for when the global one above is in use,
+// or when you have a whole buffer to check at once.
+typedef struct {
+	unsigned short crc;
+} Crc16Context;
+
+// Call this before distinct runs of CRC values in ctx.
+inline void crc16InitContext(Crc16Context* ctx)  { ctx->crc = 0; }
+
+// Adds the len bytes at buf to the CRC in ctx, and returns the new CRC.
+// Much faster than calling crc16() per byte.
+unsigned short crc16Block(Crc16Context* ctx, unsigned char* buf, unsigned char len);
+
+
+#endif
+//__CRC_16BIT_H
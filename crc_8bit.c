@@ -13,13 +13,27 @@
 	two other algorithms are shown. One uses nibble arrays and
 	the other uses boolean arithmetic.
 	
+	All three are built from the CRCs of the eight single-bit bytes,
+	so the tables are generated by the preprocessor rather than pasted in.
+	
+	Rough costs, per byte: the table is fastest and uses 256 bytes of ROM;
+	the nibbles are nearly as fast and use 32; the bits use no table, but
+	take a test and XOR per bit.  Define TEST_CRC_8BIT to build a main()
+	that times each with the SourceBoost simulator's stopwatch.
+	
+	This also builds on a PC, where it always uses the table, and adds crc8BlockLong()
+	for checking large captures, with faster kernels that give the same results.
+	Define TEST_CRC_8BIT there to check them against the table, and time them.
+	
 	
 	18JAN03 - T. Scott Dattalo
 	
 	Modified by Timothy Weber.
 */
 
+#ifdef _BOOSTC
 #include <system.h>
+#endif
 
 #define IN_CRC_8BIT
 
@@ -27,55 +41,62 @@
 
 
 // Choose your favorite implementation by defining (only) one of these macros.
+#ifndef _BOOSTC
+ #undef CRC8_IMP_NIBBLES
+ #undef CRC8_IMP_BITS
+ #define CRC8_IMP_TABLE
+#endif
 #if !defined(CRC8_IMP_TABLE) && !defined(CRC8_IMP_NIBBLES) && !defined(CRC8_IMP_BITS)
  #define CRC8_IMP_BITS
 #endif
 
 
+// The CRC of each byte with a single bit set.
+// The CRC is linear, so the CRC of any byte is the XOR of these for each of its bits.
+#define CRC8_BIT0  0x5e
+#define CRC8_BIT1  0xbc
+#define CRC8_BIT2  0x61
+#define CRC8_BIT3  0xc2
+#define CRC8_BIT4  0x9d
+#define CRC8_BIT5  0x23
+#define CRC8_BIT6  0x46
+#define CRC8_BIT7  0x8c
+
+// The CRC of the constant byte i, evaluated at compile time.
+#define CRC8_OF(i)  ( \
+	(((i) & 0x01) ? CRC8_BIT0 : 0) ^ (((i) & 0x02) ? CRC8_BIT1 : 0) ^ \
+	(((i) & 0x04) ? CRC8_BIT2 : 0) ^ (((i) & 0x08) ? CRC8_BIT3 : 0) ^ \
+	(((i) & 0x10) ? CRC8_BIT4 : 0) ^ (((i) & 0x20) ? CRC8_BIT5 : 0) ^ \
+	(((i) & 0x40) ? CRC8_BIT6 : 0) ^ (((i) & 0x80) ? CRC8_BIT7 : 0))
+
+// Eight consecutive table entries, starting at i.
+#define CRC8_ROW(i)  \
+	CRC8_OF(i), CRC8_OF((i) + 1), CRC8_OF((i) + 2), CRC8_OF((i) + 3), \
+	CRC8_OF((i) + 4), CRC8_OF((i) + 5), CRC8_OF((i) + 6), CRC8_OF((i) + 7)
+
+
 #ifdef CRC8_IMP_TABLE
 
 // crc array from the Maxim ApNote
+#ifdef _BOOSTC
 rom char* crc_array = {
-	0x00, 0x5e, 0xbc, 0xe2, 0x61, 0x3f, 0xdd, 0x83, 
-	0xc2, 0x9c, 0x7e, 0x20, 0xa3, 0xfd, 0x1f, 0x41, 
-	0x9d, 0xc3, 0x21, 0x7f, 0xfc, 0xa2, 0x40, 0x1e, 
-	0x5f, 0x01, 0xe3, 0xbd, 0x3e, 0x60, 0x82, 0xdc, 
-	0x23, 0x7d, 0x9f, 0xc1, 0x42, 0x1c, 0xfe, 0xa0, 
-	0xe1, 0xbf, 0x5d, 0x03, 0x80, 0xde, 0x3c, 0x62, 
-	0xbe, 0xe0, 0x02, 0x5c, 0xdf, 0x81, 0x63, 0x3d, 
-	0x7c, 0x22, 0xc0, 0x9e, 0x1d, 0x43, 0xa1, 0xff, 
-	0x46, 0x18, 0xfa, 0xa4, 0x27, 0x79, 0x9b, 0xc5, 
-	0x84, 0xda, 0x38, 0x66, 0xe5, 0xbb, 0x59, 0x07, 
-	0xdb, 0x85, 0x67, 0x39, 0xba, 0xe4, 0x06, 0x58, 
-	0x19, 0x47, 0xa5, 0xfb, 0x78, 0x26, 0xc4, 0x9a, 
-	0x65, 0x3b, 0xd9, 0x87, 0x04, 0x5a, 0xb8, 0xe6, 
-	0xa7, 0xf9, 0x1b, 0x45, 0xc6, 0x98, 0x7a, 0x24, 
-	0xf8, 0xa6, 0x44, 0x1a, 0x99, 0xc7, 0x25, 0x7b, 
-	0x3a, 0x64, 0x86, 0xd8, 0x5b, 0x05, 0xe7, 0xb9, 
-	0x8c, 0xd2, 0x30, 0x6e, 0xed, 0xb3, 0x51, 0x0f, 
-	0x4e, 0x10, 0xf2, 0xac, 0x2f, 0x71, 0x93, 0xcd, 
-	0x11, 0x4f, 0xad, 0xf3, 0x70, 0x2e, 0xcc, 0x92, 
-	0xd3, 0x8d, 0x6f, 0x31, 0xb2, 0xec, 0x0e, 0x50, 
-	0xaf, 0xf1, 0x13, 0x4d, 0xce, 0x90, 0x72, 0x2c, 
-	0x6d, 0x33, 0xd1, 0x8f, 0x0c, 0x52, 0xb0, 0xee, 
-	0x32, 0x6c, 0x8e, 0xd0, 0x53, 0x0d, 0xef, 0xb1, 
-	0xf0, 0xae, 0x4c, 0x12, 0x91, 0xcf, 0x2d, 0x73, 
-	0xca, 0x94, 0x76, 0x28, 0xab, 0xf5, 0x17, 0x49, 
-	0x08, 0x56, 0xb4, 0xea, 0x69, 0x37, 0xd5, 0x8b, 
-	0x57, 0x09, 0xeb, 0xb5, 0x36, 0x68, 0x8a, 0xd4, 
-	0x95, 0xcb, 0x29, 0x77, 0xf4, 0xaa, 0x48, 0x16, 
-	0xe9, 0xb7, 0x55, 0x0b, 0x88, 0xd6, 0x34, 0x6a, 
-	0x2b, 0x75, 0x97, 0xc9, 0x4a, 0x14, 0xf6, 0xa8, 
-	0x74, 0x2a, 0xc8, 0x96, 0x15, 0x4b, 0xa9, 0xf7, 
-	0xb6, 0xe8, 0x0a, 0x54, 0xd7, 0x89, 0x6b, 0x35, 
+#else
+static const unsigned char crc_array[256] = {
+#endif
+	CRC8_ROW(0x00), CRC8_ROW(0x08), CRC8_ROW(0x10), CRC8_ROW(0x18),
+	CRC8_ROW(0x20), CRC8_ROW(0x28), CRC8_ROW(0x30), CRC8_ROW(0x38),
+	CRC8_ROW(0x40), CRC8_ROW(0x48), CRC8_ROW(0x50), CRC8_ROW(0x58),
+	CRC8_ROW(0x60), CRC8_ROW(0x68), CRC8_ROW(0x70), CRC8_ROW(0x78),
+	CRC8_ROW(0x80), CRC8_ROW(0x88), CRC8_ROW(0x90), CRC8_ROW(0x98),
+	CRC8_ROW(0xa0), CRC8_ROW(0xa8), CRC8_ROW(0xb0), CRC8_ROW(0xb8),
+	CRC8_ROW(0xc0), CRC8_ROW(0xc8), CRC8_ROW(0xd0), CRC8_ROW(0xd8),
+	CRC8_ROW(0xe0), CRC8_ROW(0xe8), CRC8_ROW(0xf0), CRC8_ROW(0xf8),
 };
 
-unsigned char crc8(unsigned char data)
+// Returns the CRC, given the data byte XORed with the previous CRC.
+inline unsigned char crc8Step(unsigned char i)
 {
-	unsigned char i = (data ^ crc);
-	
-	crc = crc_array[i];
-	return crc;
+	return crc_array[i];
 }
 
 #endif
@@ -84,48 +105,378 @@ unsigned char crc8(unsigned char data)
 
 // CRC arrays for the nibble-wise routine.
 rom char* r1 = {
-	0x00, 0x5e, 0xbc, 0xe2, 0x61, 0x3f, 0xdd, 0x83, 
-	0xc2, 0x9c, 0x7e, 0x20, 0xa3, 0xfd, 0x1f, 0x41, 
+	CRC8_ROW(0x00), CRC8_ROW(0x08)
 };
 
 rom char* r2 = {
-	0x00, 0x9d, 0x23, 0xbe, 0x46, 0xdb, 0x65, 0xf8,
-	0x8c, 0x11, 0xaf, 0x32, 0xca, 0x57, 0xe9, 0x74
+	CRC8_OF(0x00), CRC8_OF(0x10), CRC8_OF(0x20), CRC8_OF(0x30),
+	CRC8_OF(0x40), CRC8_OF(0x50), CRC8_OF(0x60), CRC8_OF(0x70),
+	CRC8_OF(0x80), CRC8_OF(0x90), CRC8_OF(0xa0), CRC8_OF(0xb0),
+	CRC8_OF(0xc0), CRC8_OF(0xd0), CRC8_OF(0xe0), CRC8_OF(0xf0)
 };
 
-unsigned char crc8(unsigned char data)
+inline unsigned char crc8Step(unsigned char i)
 {
-	unsigned char i = (data ^ crc);
-	
-	crc = r1[i & 0xf] ^ r2[i >> 4];
-	return crc;
+	return r1[i & 0xf] ^ r2[i >> 4];
 }
 #endif
 
 #ifdef CRC8_IMP_BITS
-unsigned char crc8(unsigned char data)
+inline unsigned char crc8Step(unsigned char i)
 {
-	unsigned char i = (data ^ crc);
-	
-	crc = 0;
+	unsigned char result = 0;
 	
 	if(i & 1)
-		crc ^= 0x5e;
+		result ^= CRC8_BIT0;
 	if(i & 2)
-		crc ^= 0xbc;
+		result ^= CRC8_BIT1;
 	if(i & 4)
-		crc ^= 0x61;
+		result ^= CRC8_BIT2;
 	if(i & 8)
-		crc ^= 0xc2;
+		result ^= CRC8_BIT3;
 	if(i & 0x10)
-		crc ^= 0x9d;
+		result ^= CRC8_BIT4;
 	if(i & 0x20)
-		crc ^= 0x23;
+		result ^= CRC8_BIT5;
 	if(i & 0x40)
-		crc ^= 0x46;
+		result ^= CRC8_BIT6;
 	if(i & 0x80)
-		crc ^= 0x8c;
+		result ^= CRC8_BIT7;
 	
+	return result;
+}
+#endif
+
+unsigned char crc8(unsigned char data)
+{
+	crc = crc8Step(data ^ crc);
 	return crc;
 }
-#endif
\ No newline at end of file
+
+unsigned char crc8Block(Crc8Context* ctx, unsigned char* buf, unsigned char len)
+{
+#ifdef _BOOSTC
+	unsigned char c = ctx->crc;
+	
+	while (len--)
+		c = crc8Step(*buf++ ^ c);
+		
+	ctx->crc = c;
+	return c;
+#else
+	return crc8BlockLong(ctx, buf, len);
+#endif
+}
+
+#ifndef _BOOSTC
+/*	Kernels for a PC.  Each takes the CRC so far, and returns it with len more bytes added.
+	
+	Slice-by-8 looks up each of 8 bytes in its own table, holding the CRC of that byte
+	followed by as many zero bytes as there are bytes after it, and XORs the 8 together.
+	The CRC is linear, so that's the same as going a byte at a time, but the lookups
+	don't have to wait for each other.
+	
+	On x86 with PCLMULQDQ, the carry-less multiply folds the data into four 128-bit
+	remainders, 64 bytes at a time, as in Intel's "Fast CRC Computation for Generic
+	Polynomials Using PCLMULQDQ".  Each remainder stands for a polynomial with the first bit
+	at the top, as the CRC is shifted in LSB first.  Its first 64 bits are multiplied by
+	x^(64 + n) mod P, and the rest by x^n mod P, to move it n bits further along; the sum is
+	congruent, so it has the same CRC.  What's left over is finished with slice-by-8.
+*/
+
+typedef unsigned char (*Crc8Kernel)(unsigned char c, const unsigned char* buf, size_t len);
+
+static unsigned char crc8KernelTable(unsigned char c, const unsigned char* buf, size_t len)
+{
+	while (len--)
+		c = crc8Step(*buf++ ^ c);
+	return c;
+}
+
+// crc8Slices[k][i] is the CRC of byte i followed by k zero bytes.
+static unsigned char crc8Slices[8][256];
+
+static void crc8InitSlices(void)
+{
+	unsigned int i, k;
+	
+	for (i = 0; i < 256; i++)
+		crc8Slices[0][i] = crc8Step(i);
+	for (k = 1; k < 8; k++)
+		for (i = 0; i < 256; i++)
+			crc8Slices[k][i] = crc8Step(crc8Slices[k - 1][i]);
+}
+
+static unsigned char crc8KernelSlice8(unsigned char c, const unsigned char* buf, size_t len)
+{
+	for (; len >= 8; len -= 8, buf += 8)
+		c = crc8Slices[7][buf[0] ^ c] ^ crc8Slices[6][buf[1]] ^ crc8Slices[5][buf[2]] ^ crc8Slices[4][buf[3]]
+			^ crc8Slices[3][buf[4]] ^ crc8Slices[2][buf[5]] ^ crc8Slices[1][buf[6]] ^ crc8Slices[0][buf[7]];
+			
+	return crc8KernelTable(c, buf, len);
+}
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define CRC8_CLMUL
+#include <immintrin.h>
+
+#define CRC8_CLMUL_TARGET  __attribute__((target("sse2,pclmul")))
+
+// The polynomial, with x^8 in bit 8.
+#define CRC8_POLY  0x131
+
+// Returns x^n mod P, bit-reversed into the top byte of 64 bits, the way the remainders hold it.
+// It's x^(n - 1) rather than x^n, since a carry-less multiply of two bit-reversed numbers
+// comes out one place short.
+static unsigned long long crc8FoldConstant(unsigned int n)
+{
+	unsigned int r = 1;
+	unsigned long long k = 0;
+	unsigned char d;
+	
+	while (--n) {
+		r <<= 1;
+		if (r & 0x100)
+			r ^= CRC8_POLY;
+	}
+	for (d = 0; d < 8; d++)
+		if (r & (1 << d))
+			k |= 1ULL << (63 - d);
+	return k;
+}
+
+// Folding constants, for moving a remainder along 512 bits and 128 bits;
+// the low half multiplies the first 64 bits.
+static unsigned long long crc8Fold512[2], crc8Fold128[2];
+
+static void crc8InitClmul(void)
+{
+	crc8Fold512[0] = crc8FoldConstant(512 + 64);
+	crc8Fold512[1] = crc8FoldConstant(512);
+	crc8Fold128[0] = crc8FoldConstant(128 + 64);
+	crc8Fold128[1] = crc8FoldConstant(128);
+}
+
+// Returns a moved along by the distance k is for, plus the next data d.
+CRC8_CLMUL_TARGET static inline __m128i crc8Fold(__m128i a, __m128i k, __m128i d)
+{
+	return _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(a, k, 0x00), _mm_clmulepi64_si128(a, k, 0x11)), d);
+}
+
+CRC8_CLMUL_TARGET static unsigned char crc8KernelClmul(unsigned char c, const unsigned char* buf, size_t len)
+{
+	if (len < 64)
+		return crc8KernelSlice8(c, buf, len);
+		
+	const __m128i* p = (const __m128i*) buf;
+	__m128i k512 = _mm_set_epi64x(crc8Fold512[1], crc8Fold512[0]);
+	__m128i k128 = _mm_set_epi64x(crc8Fold128[1], crc8Fold128[0]);
+	
+	// The CRC so far goes into the first byte.
+	__m128i a0 = _mm_xor_si128(_mm_loadu_si128(p), _mm_cvtsi32_si128(c));
+	__m128i a1 = _mm_loadu_si128(p + 1);
+	__m128i a2 = _mm_loadu_si128(p + 2);
+	__m128i a3 = _mm_loadu_si128(p + 3);
+	p += 4;
+	len -= 64;
+	
+	for (; len >= 64; len -= 64, p += 4) {
+		a0 = crc8Fold(a0, k512, _mm_loadu_si128(p));
+		a1 = crc8Fold(a1, k512, _mm_loadu_si128(p + 1));
+		a2 = crc8Fold(a2, k512, _mm_loadu_si128(p + 2));
+		a3 = crc8Fold(a3, k512, _mm_loadu_si128(p + 3));
+	}
+	
+	// Down to one, then the rest of the whole 16-byte blocks.
+	a0 = crc8Fold(a0, k128, a1);
+	a0 = crc8Fold(a0, k128, a2);
+	a0 = crc8Fold(a0, k128, a3);
+	for (; len >= 16; len -= 16, p++)
+		a0 = crc8Fold(a0, k128, _mm_loadu_si128(p));
+		
+	// The remainder's CRC is the same as the data's.
+	unsigned char remainder[16];
+	_mm_storeu_si128((__m128i*) remainder, a0);
+	c = crc8KernelSlice8(0, remainder, sizeof(remainder));
+	return crc8KernelSlice8(c, (const unsigned char*) p, len);
+}
+#endif
+
+static Crc8Kernel crc8Kernel;
+static const char* crc8KernelUsed;
+
+// Picks the fastest kernel, the first time it's needed.
+static void crc8PickKernel(void)
+{
+	crc8InitSlices();
+	crc8KernelUsed = "slice-by-8";
+	Crc8Kernel kernel = crc8KernelSlice8;
+	
+	#ifdef CRC8_CLMUL
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("sse2") && __builtin_cpu_supports("pclmul")) {
+		crc8InitClmul();
+		crc8KernelUsed = "pclmul";
+		kernel = crc8KernelClmul;
+	}
+	#endif
+	
+	// Last, since this says the tables are ready.
+	crc8Kernel = kernel;
+}
+
+unsigned char crc8BlockLong(Crc8Context* ctx, const unsigned char* buf, size_t len)
+{
+	if (!crc8Kernel)
+		crc8PickKernel();
+	ctx->crc = crc8Kernel(ctx->crc, buf, len);
+	return ctx->crc;
+}
+
+const char* crc8KernelName(void)
+{
+	if (!crc8Kernel)
+		crc8PickKernel();
+	return crc8KernelUsed;
+}
+#endif
+
+#ifdef TEST_CRC_8BIT
+#ifdef _BOOSTC
+// Time these in the simulator, from one breakpoint to the next.
+unsigned char testBuf[64];
+
+void main(void)
+{
+	// The ROM code from the Maxim ApNote, followed by its CRC.
+	unsigned char rom_code[8] = { 0x02, 0x1c, 0xb8, 0x01, 0x00, 0x00, 0x00, 0xa2 };
+	unsigned char check[10] = "123456789";
+	Crc8Context ctx;
+	unsigned char c;
+	unsigned char i;
+	
+	// Should be 0xa2.
+	crc8InitContext(&ctx);
+	c = crc8Block(&ctx, rom_code, 7);
+	
+	// Including the CRC, should be 0.
+	crc8InitContext(&ctx);
+	c = crc8Block(&ctx, rom_code, 8);
+	
+	// The same, a byte at a time; should also be 0.
+	crc8Init();
+	for (i = 0; i < 8; i++)
+		crc8(rom_code[i]);
+	c = crc;
+	
+	// The standard check value for this CRC; should be 0xa1.
+	crc8InitContext(&ctx);
+	c = crc8Block(&ctx, check, 9);
+	
+	// Cycles per byte, over a longer buffer.
+	for (i = 0; i < sizeof(testBuf); i++)
+		testBuf[i] = i * 37;
+	crc8InitContext(&ctx);
+	c = crc8Block(&ctx, testBuf, sizeof(testBuf));
+	
+	c = 0;
+}
+#else
+/*	Differential test of the kernels for a PC, against the table and a plain shift register:
+		g++ -x c++ -O2 -DTEST_CRC_8BIT crc_8bit.c -o crc8test
+		crc8test [megabytes to time]
+	Exits with 1 if any kernel disagrees.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// The CRC the long way, a bit at a time, with the bit-reversed polynomial.
+static unsigned char testShiftRegister(unsigned char c, const unsigned char* buf, size_t len)
+{
+	while (len--) {
+		c ^= *buf++;
+		for (int i = 0; i < 8; i++)
+			c = (c & 1) ? (c >> 1) ^ 0x8C : c >> 1;
+	}
+	return c;
+}
+
+static const struct {
+	const char* name;
+	Crc8Kernel kernel;
+} testKernels[] = {
+	{ "table", crc8KernelTable },
+	{ "slice-by-8", crc8KernelSlice8 },
+	#ifdef CRC8_CLMUL
+	{ "pclmul", crc8KernelClmul },
+	#endif
+};
+#define TEST_KERNELS  (sizeof(testKernels) / sizeof(testKernels[0]))
+
+int main(int argc, char* argv[])
+{
+	size_t megabytes = argc > 1 ? atoi(argv[1]) : 256;
+	size_t size = megabytes << 20;
+	unsigned char* buf = (unsigned char*) malloc(size + 16);
+	unsigned int k;
+	unsigned long failures = 0;
+	Crc8Context ctx;
+	
+	printf("crc8BlockLong() uses %s\n", crc8KernelName());
+	
+	#ifdef CRC8_CLMUL
+	bool haveClmul = __builtin_cpu_supports("sse2") && __builtin_cpu_supports("pclmul");
+	#endif
+	
+	// The standard check value.
+	crc8InitContext(&ctx);
+	if (crc8BlockLong(&ctx, (const unsigned char*) "123456789", 9) != 0xA1) {
+		printf("check value: got %02X, not A1\n", ctx.crc);
+		failures++;
+	}
+	
+	srand(1);
+	for (size_t i = 0; i < size + 16; i++)
+		buf[i] = rand();
+		
+	// Every length up to a few blocks past the fold, at every alignment, from random starting CRCs,
+	// then random longer ones.
+	for (unsigned int trial = 0; trial < 200000; trial++) {
+		size_t len = trial < 100000 ? trial % 400 : rand() % 10000;
+		size_t offset = rand() % 16;
+		unsigned char start = rand();
+		unsigned char expected = testShiftRegister(start, buf + offset, len);
+		
+		for (k = 0; k < TEST_KERNELS; k++) {
+			#ifdef CRC8_CLMUL
+			if (testKernels[k].kernel == crc8KernelClmul && !haveClmul)
+				continue;
+			#endif
+			unsigned char got = testKernels[k].kernel(start, buf + offset, len);
+			if (got != expected) {
+				if (failures++ < 10)
+					printf("%s: length %u, offset %u, start %02X: got %02X, not %02X\n",
+						testKernels[k].name, (unsigned int) len, (unsigned int) offset, start, got, expected);
+			}
+		}
+	}
+	
+	// Throughput.
+	for (k = 0; k < TEST_KERNELS; k++) {
+		#ifdef CRC8_CLMUL
+		if (testKernels[k].kernel == crc8KernelClmul && !haveClmul)
+			continue;
+		#endif
+		clock_t begin = clock();
+		unsigned char c = testKernels[k].kernel(0, buf, size);
+		double seconds = (double) (clock() - begin) / CLOCKS_PER_SEC;
+		printf("%-12s %02X  %8.0f MB/s\n", testKernels[k].name, c, megabytes / (seconds > 0 ? seconds : 1e-9));
+	}
+	
+	printf(failures ? "%lu failures\n" : "all kernels agree\n", failures);
+	free(buf);
+	return failures ? 1 : 0;
+}
+#endif
+#endif
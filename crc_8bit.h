@@ -10,6 +10,11 @@
 	The Ap note describes the CRC-8 algorithm used in the 
 	iButton products.
 	
+	In the usual catalog terms, this is CRC-8/MAXIM: polynomial x^8 + x^5 + x^4 + 1
+	(0x31, or 0x8C bit-reversed), shifted in LSB first, starting at 0, with no final XOR.
+	The CRC of the ASCII string "123456789" is 0xA1.
+	Any other implementation that checks the same data (on a PC, say) must match these.
+	
 	18JAN03 - T. Scott Dattalo
 	
 	Modified by Timothy Weber.
@@ -35,6 +40,31 @@ inline void crc8Init(void)  { crc = 0; }
 // Returns the CRC of the given byte, preceded by all bytes since crcInit().
 unsigned char crc8(unsigned char data);
 
+// An explicit CRC state, for when the global one above is in use,
+// or when you have a whole buffer to check at once.
+typedef struct {
+	unsigned char crc;
+} Crc8Context;
+
+// Call this before distinct runs of CRC values in ctx.
+inline void crc8InitContext(Crc8Context* ctx)  { ctx->crc = 0; }
+
+// Adds the len bytes at buf to the CRC in ctx, and returns the new CRC.
+// Much faster than calling crc8() per byte.
+// Including a received CRC byte at the end of buf gives a result of 0 if the data is good.
+unsigned char crc8Block(Crc8Context* ctx, unsigned char* buf, unsigned char len);
+
+#ifndef _BOOSTC
+#include <stddef.h>
+
+// On a PC, for checking large captures: the same as crc8Block(), for any length,
+// using the fastest kernel the CPU has.  See crc_8bit.c.
+unsigned char crc8BlockLong(Crc8Context* ctx, const unsigned char* buf, size_t len);
+
+// The name of the kernel crc8BlockLong() uses, for logging.
+const char* crc8KernelName(void);
+#endif
+
 
 #endif
 //__CRC_8BIT_H
\ No newline at end of file
@@ -29,11 +29,30 @@
 	- Similarly, you can divide a fixed-point by a plain integer directly
 		to get a fixed-point result.  (The numerator must be fixed,
 		and the denominator must be the plain integer.)
+		
+	- Or, use fixedMul() and fixedDiv(), which do the shifts in the right place
+		on a 32-bit intermediate, so no precision is lost along the way.
+		Use the shift rules above by hand only where you know the magnitudes
+		well enough that a 16-bit intermediate can't overflow.
+		
+	For code on a PC that has to match these results exactly (e.g., when processing logged readings):
+	a fixed16 f is exactly f / 256.0 as a float or double, so converting is just a multiply by 1/256,
+	and any number of values can be converted at once.  The display helpers below are integer-only,
+	so a port must follow their integer steps rather than rounding the double; in particular, see
+	the notes on negative values at fixedRoundToTenths().  fixed32.c has array versions of these
+	for a PC, which do.
 */
 
 #ifndef __FIXED16_H
 #define __FIXED16_H
 
+#if !defined(_BOOSTC) && !defined(HIBYTE)
+// On a PC, the BoostC byte macros used below.
+#define HIBYTE(dst, src)  ((dst) = (src) >> 8)
+#define LOBYTE(dst, src)  ((dst) = (src) & 0xFF)
+#define MAKESHORT(dst, lo, hi)  ((dst) = ((unsigned short) (hi) << 8) | (unsigned char) (lo))
+#endif
+
 typedef signed short fixed16;
 
 // Returns b converted to fixed-point, with no fractional part.
@@ -42,7 +61,7 @@ inline fixed16 fixedFromByte(char b)
 	return ((fixed16) b) << 8;
 }
 // This version is more efficient.
-#define FIXED_FROM_BYTE(b)  (b << 8)
+#define FIXED_FROM_BYTE(b)  ((fixed16) (b) << 8)
 
 // Returns b as a fixed-point fraction, with no integral part.
 inline fixed16 fixedFracFromByte(char b)
@@ -50,17 +69,21 @@ inline fixed16 fixedFracFromByte(char b)
 	return (fixed16) b;
 }
 // This version is more efficient.
-#define FIXED_FRAC_FROM_BYTE(b)  (b)
+#define FIXED_FRAC_FROM_BYTE(b)  ((fixed16) (b))
 
 #define FIXED_ONE_HALF  0x80
 
+// The largest and smallest values; the saturating functions below stop here.
+#define FIXED_MAX  ((fixed16) 0x7FFF)
+#define FIXED_MIN  ((fixed16) 0x8000)
+
 inline fixed16 makeFixed(char integral, unsigned char fractional)
 {
 	return (((fixed16) integral) << 8) | ((fixed16) fractional);
 }
 // This version is more efficient.
 #define MAKE_FIXED(result, integral, fractional)  MAKESHORT(result, fractional, integral)
-#define MAKE_FIXED_CONST(integral, fractional)  (integral * 256 + fractional)
+#define MAKE_FIXED_CONST(integral, fractional)  ((integral) * 256 + (fractional))
 
 // Returns the integral part of f in i.
 // Note that this moves downward for negative numbers, e.g. fixedFloor(-0.5) = -1.
@@ -95,7 +118,7 @@ inline signed char fixedIntegral(fixed16 f)
 	return f >> 8;
 }
 // More efficient.
-#define FIXED_INTEGRAL(f)  (f >> 8)
+#define FIXED_INTEGRAL(f)  ((f) >> 8)
 
 // Return the largest integer <= f, as a fixed-point value.
 // Note that this moves downward for negative numbers, e.g. fixedFloor(-0.5) = -1.
@@ -118,6 +141,10 @@ inline unsigned char fixedTenths(fixed16 f)
 
 // Round f to the nearest tenth, and unpack it into a signed integer value
 // and an unsigned number of tenths, from 0-9.
+// For negative f, the tenths are rounded from the magnitude, and units moves toward zero,
+// so -1.5 gives -1 and 5.  But the sign is carried only by units, so values between -1 and 0
+// come out positive (-0.5 gives 0 and 5), and rounding up to a whole number moves units
+// the wrong way (-1.97 gives 0 and 0).
 inline void fixedRoundToTenths(fixed16 f, signed char& units, unsigned char& tenths)
 {
 	fixed16 tempFixed;
@@ -163,10 +190,84 @@ inline signed char fixedRoundToByte(fixed16 f)
 	return (signed char)((f + FIXED_ONE_HALF) >> 8);
 }
 		
+// Returns a * b, rounded down.
+// The product is formed in 32 bits, and shifted down afterwards.
+inline fixed16 fixedMul(fixed16 a, fixed16 b)
+{
+	return (fixed16) (((signed long) a * b) >> 8);
+}
+
+// Returns a / b, rounded toward zero.
+// The dividend is widened to 32 bits and shifted up beforehand.
+inline fixed16 fixedDiv(fixed16 a, fixed16 b)
+{
+	return (fixed16) (((signed long) a << 8) / b);
+}
+
 // Return 1/f.
 inline fixed16 fixedReciprocal(fixed16 f)
 {
 	return ((1 << 8) / f) << 8;
 }
 
+// Saturating arithmetic.
+// These return FIXED_MAX or FIXED_MIN instead of wrapping around when the result is out of range.
+// Products and quotients are rounded to the nearest 1/256, with halves rounded away from zero.
+
+inline fixed16 fixedAddSat(fixed16 a, fixed16 b)
+{
+	fixed16 result = a + b;
+	
+	// Overflow only happens when both operands have the sign the result doesn't.
+	if (((a ^ result) & (b ^ result)) < 0)
+		return (a < 0) ? FIXED_MIN : FIXED_MAX;
+	return result;
+}
+
+inline fixed16 fixedSubSat(fixed16 a, fixed16 b)
+{
+	fixed16 result = a - b;
+	
+	// Overflow only happens when the operands' signs differ, and the result's differs from a's.
+	if (((a ^ b) & (a ^ result)) < 0)
+		return (a < 0) ? FIXED_MIN : FIXED_MAX;
+	return result;
+}
+
+// Clamps a 32-bit intermediate to the range of fixed16.
+inline fixed16 fixedClamp(signed long x)
+{
+	if (x > FIXED_MAX)
+		return FIXED_MAX;
+	if (x < FIXED_MIN)
+		return FIXED_MIN;
+	return (fixed16) x;
+}
+
+inline fixed16 fixedMulSat(fixed16 a, fixed16 b)
+{
+	signed long p = (signed long) a * b;
+	
+	if (p < 0)
+		return fixedClamp(-((-p + FIXED_ONE_HALF) >> 8));
+	else
+		return fixedClamp((p + FIXED_ONE_HALF) >> 8);
+}
+
+// Division by zero returns FIXED_MAX or FIXED_MIN, by the sign of a (or 0 if a is 0).
+inline fixed16 fixedDivSat(fixed16 a, fixed16 b)
+{
+	if (b == 0)
+		return (a < 0) ? FIXED_MIN : (a > 0) ? FIXED_MAX : 0;
+		
+	// Divide the magnitudes, so the rounding is symmetric.
+	unsigned long n = (a < 0) ? -(signed long) a : a;
+	unsigned short d = (b < 0) ? -(signed long) b : b;
+	signed long q = ((n << 8) + (d >> 1)) / d;
+	
+	if ((a ^ b) < 0)
+		q = -q;
+	return fixedClamp(q);
+}
+
 #endif
@@ -0,0 +1,636 @@
+/* fixed32.c
+    Copyright (c) 2026 by Timothy J. Weber, tw@timothyweber.org.
+
+	The larger saturating operations on 16.16 fixed-point numbers.
+	There's no 64-bit type, so these work on the magnitudes in pieces,
+	watching for the result going out of range along the way.
+	
+	On a PC, where long is 64 bits, these just clamp a 64-bit product or quotient instead;
+	that's also where the array conversions from fixed32.h are, for processing logged
+	readings.  Define TEST_FIXED32 there to check them against the per-element functions,
+	and time them.
+*/
+
+#ifdef _BOOSTC
+#include <system.h>
+#endif
+
+#include "fixed32.h"
+
+#ifdef _BOOSTC
+
+// Returns the magnitude, sign and clamping limit for a result of the given sign.
+// (The negative range is one larger than the positive one.)
+#define MAGNITUDE(x)  ((x) < 0 ? -(unsigned long) (x) : (unsigned long) (x))
+#define LIMIT(negative)  ((negative) ? 0x80000000 : 0x7FFFFFFF)
+
+// Returns the magnitude m, with the given sign.
+// m must already be within LIMIT(negative).
+inline fixed32 applySign(unsigned long m, bit negative)
+{
+	if (negative)
+		return -(fixed32) m;
+	else
+		return (fixed32) m;
+}
+
+fixed32 fixed32MulSat(fixed32 a, fixed32 b)
+{
+	bit negative = (a ^ b) < 0;
+	unsigned long am = MAGNITUDE(a);
+	unsigned long bm = MAGNITUDE(b);
+	unsigned long limit = LIMIT(negative);
+	
+	unsigned short ai = am >> 16;
+	unsigned short af = am & 0xFFFF;
+	unsigned short bi = bm >> 16;
+	unsigned short bf = bm & 0xFFFF;
+	
+	// Sum the partial products, shifted into place.
+	// Only the last one has a fractional part, so that's the only one to round.
+	unsigned long term = (unsigned long) ai * bi;
+	if (term > 0x8000)
+		return negative ? FIXED32_MIN : FIXED32_MAX;
+	unsigned long result = term << 16;
+	
+	term = (unsigned long) ai * bf;
+	result += term;
+	if (result < term)  // carried out
+		return negative ? FIXED32_MIN : FIXED32_MAX;
+	
+	term = (unsigned long) af * bi;
+	result += term;
+	if (result < term)
+		return negative ? FIXED32_MIN : FIXED32_MAX;
+	
+	term = ((unsigned long) af * bf + 0x8000) >> 16;
+	result += term;
+	if (result < term || result > limit)
+		return negative ? FIXED32_MIN : FIXED32_MAX;
+		
+	return applySign(result, negative);
+}
+
+fixed32 fixed32DivSat(fixed32 a, fixed32 b)
+{
+	bit negative = (a ^ b) < 0;
+	
+	if (b == 0)
+		return (a < 0) ? FIXED32_MIN : (a > 0) ? FIXED32_MAX : 0;
+	
+	unsigned long n = MAGNITUDE(a);
+	unsigned long d = MAGNITUDE(b);
+	unsigned long limit = LIMIT(negative);
+	
+	// The integral part of the quotient.
+	unsigned long q = n / d;
+	unsigned long r = n - q * d;
+	if (q > (limit >> 16))
+		return negative ? FIXED32_MIN : FIXED32_MAX;
+	
+	// Then 16 fractional bits, by long division.
+	// r < d <= 0x80000000, so r can be doubled without overflow.
+	unsigned char i;
+	for (i = 0; i < 16; i++) {
+		q <<= 1;
+		r <<= 1;
+		if (r >= d) {
+			r -= d;
+			q |= 1;
+		}
+	}
+	
+	// Round to nearest: up if the remainder is at least half the divisor.
+	if (r >= d - r)
+		++q;
+		
+	if (q > limit)
+		return negative ? FIXED32_MIN : FIXED32_MAX;
+	return applySign(q, negative);
+}
+
+#else
+#include <stdint.h>
+
+/*	The saturating operations, for a PC.
+	The operands are taken as the 32 bits the PIC would store, so the product and the
+	shifted dividend fit in 64 bits; the rounding is the same as above.
+*/
+
+// Returns the magnitude m with the given sign, or the limit if m is past it.
+static fixed32 fixed32Clamp(uint64_t m, int negative)
+{
+	if (negative)
+		return (m > 0x80000000) ? FIXED32_MIN : -(fixed32) m;
+	return (m > 0x7FFFFFFF) ? FIXED32_MAX : (fixed32) m;
+}
+
+#define MAGNITUDE(x)  ((x) < 0 ? -(uint64_t) (x) : (uint64_t) (x))
+
+fixed32 fixed32MulSat(fixed32 a, fixed32 b)
+{
+	int64_t product = (int64_t) (int32_t) a * (int32_t) b;
+	
+	return fixed32Clamp((MAGNITUDE(product) + 0x8000) >> 16, product < 0);
+}
+
+fixed32 fixed32DivSat(fixed32 a, fixed32 b)
+{
+	int32_t a32 = (int32_t) a;
+	int32_t b32 = (int32_t) b;
+	
+	if (b32 == 0)
+		return (a32 < 0) ? FIXED32_MIN : (a32 > 0) ? FIXED32_MAX : 0;
+	
+	uint64_t n = MAGNITUDE(a32) << 16;
+	uint64_t d = MAGNITUDE(b32);
+	uint64_t q = n / d;
+	uint64_t r = n - q * d;
+	
+	// Round to nearest: up if the remainder is at least half the divisor.
+	if (r >= d - r)
+		++q;
+	return fixed32Clamp(q, (a32 ^ b32) < 0);
+}
+
+/*	The array conversions, for a PC.
+	Each SIMD kernel converts as many whole vectors as fit, and returns how many that was;
+	the rest go through the per-element function, which is also what the kernels are checked against.
+	The integer ones work on 16-bit lanes, where the results wrap the same way as in a signed char.
+*/
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define FIXED_ARRAY_X86
+#include <immintrin.h>
+
+#define FIXED_SSE2  __attribute__((target("sse2")))
+#define FIXED_AVX2  __attribute__((target("avx2")))
+#endif
+
+// Which kernels to use: 0 for none, 1 for SSE2, 2 for AVX2; -1 until the CPU has been checked.
+static int fixedArrayLevel = -1;
+
+static int FixedArrayLevel(void)
+{
+	if (fixedArrayLevel < 0) {
+		int level = 0;
+		#ifdef FIXED_ARRAY_X86
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("avx2"))
+			level = 2;
+		else if (__builtin_cpu_supports("sse2"))
+			level = 1;
+		#endif
+		fixedArrayLevel = level;
+	}
+	return fixedArrayLevel;
+}
+
+const char* fixedArrayKernelName(void)
+{
+	static const char* names[] = { "scalar", "sse2", "avx2" };
+	return names[FixedArrayLevel()];
+}
+
+// The integer conversions, as kernel operations.
+enum { FIXED_OP_INTEGRAL, FIXED_OP_TRUNC, FIXED_OP_ROUND, FIXED_OP_TENTHS };
+
+#ifdef FIXED_ARRAY_X86
+
+// Returns the op's result for each of the 8 values in f; for FIXED_OP_TENTHS, that's the units,
+// and the tenths go in *tenths.
+FIXED_SSE2 static inline __m128i fixedOpSse2(int op, __m128i f, __m128i* tenths)
+{
+	__m128i sign = _mm_srai_epi16(f, 15);
+	
+	switch (op) {
+		case FIXED_OP_INTEGRAL:
+			return _mm_srai_epi16(f, 8);
+			
+		case FIXED_OP_TRUNC: {
+			// The magnitude's integral part, with the sign put back.
+			__m128i m = _mm_srli_epi16(_mm_sub_epi16(_mm_xor_si128(f, sign), sign), 8);
+			return _mm_sub_epi16(_mm_xor_si128(m, sign), sign);
+		}
+		
+		case FIXED_OP_ROUND:
+			return _mm_srai_epi16(_mm_add_epi16(f, _mm_set1_epi16(FIXED_ONE_HALF)), 8);
+			
+		default: {
+			// The steps in fixedRoundToTenths(), with comparisons for the ifs.
+			__m128i frac = _mm_and_si128(_mm_sub_epi16(_mm_xor_si128(f, sign), sign), _mm_set1_epi16(0x00FF));
+			__m128i t = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(frac, _mm_set1_epi16(10)), _mm_set1_epi16(FIXED_ONE_HALF)), 8);
+			__m128i units = _mm_srai_epi16(f, 8);
+			__m128i hasFrac = _mm_xor_si128(_mm_cmpeq_epi16(_mm_and_si128(f, _mm_set1_epi16(0x00FF)), _mm_setzero_si128()), _mm_set1_epi16(-1));
+			units = _mm_sub_epi16(units, _mm_and_si128(sign, hasFrac));
+			__m128i over = _mm_cmpgt_epi16(t, _mm_set1_epi16(9));
+			*tenths = _mm_sub_epi16(t, _mm_and_si128(over, _mm_set1_epi16(10)));
+			return _mm_sub_epi16(units, over);
+		}
+	}
+}
+
+// The low bytes of the 16 values in a and b, in order.
+FIXED_SSE2 static inline __m128i fixedLowBytesSse2(__m128i a, __m128i b)
+{
+	__m128i mask = _mm_set1_epi16(0x00FF);
+	return _mm_packus_epi16(_mm_and_si128(a, mask), _mm_and_si128(b, mask));
+}
+
+FIXED_SSE2 static size_t fixedBytesSse2(int op, const fixed16* f, signed char* out, unsigned char* tenths, size_t n)
+{
+	size_t i;
+	
+	for (i = 0; i + 16 <= n; i += 16) {
+		__m128i t0, t1;
+		__m128i r0 = fixedOpSse2(op, _mm_loadu_si128((const __m128i*) (f + i)), &t0);
+		__m128i r1 = fixedOpSse2(op, _mm_loadu_si128((const __m128i*) (f + i + 8)), &t1);
+		_mm_storeu_si128((__m128i*) (out + i), fixedLowBytesSse2(r0, r1));
+		if (op == FIXED_OP_TENTHS)
+			_mm_storeu_si128((__m128i*) (tenths + i), fixedLowBytesSse2(t0, t1));
+	}
+	return i;
+}
+
+FIXED_AVX2 static inline __m256i fixedOpAvx2(int op, __m256i f, __m256i* tenths)
+{
+	__m256i sign = _mm256_srai_epi16(f, 15);
+	
+	switch (op) {
+		case FIXED_OP_INTEGRAL:
+			return _mm256_srai_epi16(f, 8);
+			
+		case FIXED_OP_TRUNC: {
+			__m256i m = _mm256_srli_epi16(_mm256_sub_epi16(_mm256_xor_si256(f, sign), sign), 8);
+			return _mm256_sub_epi16(_mm256_xor_si256(m, sign), sign);
+		}
+		
+		case FIXED_OP_ROUND:
+			return _mm256_srai_epi16(_mm256_add_epi16(f, _mm256_set1_epi16(FIXED_ONE_HALF)), 8);
+			
+		default: {
+			__m256i frac = _mm256_and_si256(_mm256_sub_epi16(_mm256_xor_si256(f, sign), sign), _mm256_set1_epi16(0x00FF));
+			__m256i t = _mm256_srli_epi16(_mm256_add_epi16(_mm256_mullo_epi16(frac, _mm256_set1_epi16(10)), _mm256_set1_epi16(FIXED_ONE_HALF)), 8);
+			__m256i units = _mm256_srai_epi16(f, 8);
+			__m256i hasFrac = _mm256_xor_si256(_mm256_cmpeq_epi16(_mm256_and_si256(f, _mm256_set1_epi16(0x00FF)), _mm256_setzero_si256()), _mm256_set1_epi16(-1));
+			units = _mm256_sub_epi16(units, _mm256_and_si256(sign, hasFrac));
+			__m256i over = _mm256_cmpgt_epi16(t, _mm256_set1_epi16(9));
+			*tenths = _mm256_sub_epi16(t, _mm256_and_si256(over, _mm256_set1_epi16(10)));
+			return _mm256_sub_epi16(units, over);
+		}
+	}
+}
+
+// The AVX2 pack works within each 128-bit half, so the quarters have to be put back in order.
+FIXED_AVX2 static inline __m256i fixedLowBytesAvx2(__m256i a, __m256i b)
+{
+	__m256i mask = _mm256_set1_epi16(0x00FF);
+	__m256i packed = _mm256_packus_epi16(_mm256_and_si256(a, mask), _mm256_and_si256(b, mask));
+	return _mm256_permute4x64_epi64(packed, _MM_SHUFFLE(3, 1, 2, 0));
+}
+
+FIXED_AVX2 static size_t fixedBytesAvx2(int op, const fixed16* f, signed char* out, unsigned char* tenths, size_t n)
+{
+	size_t i;
+	
+	for (i = 0; i + 32 <= n; i += 32) {
+		__m256i t0, t1;
+		__m256i r0 = fixedOpAvx2(op, _mm256_loadu_si256((const __m256i*) (f + i)), &t0);
+		__m256i r1 = fixedOpAvx2(op, _mm256_loadu_si256((const __m256i*) (f + i + 16)), &t1);
+		_mm256_storeu_si256((__m256i*) (out + i), fixedLowBytesAvx2(r0, r1));
+		if (op == FIXED_OP_TENTHS)
+			_mm256_storeu_si256((__m256i*) (tenths + i), fixedLowBytesAvx2(t0, t1));
+	}
+	return i;
+}
+
+// The 4 values in the low half of x, and the 4 in the high half, sign-extended to 32 bits.
+FIXED_SSE2 static inline __m128i fixedLowToIntsSse2(__m128i x)
+{
+	return _mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16);
+}
+FIXED_SSE2 static inline __m128i fixedHighToIntsSse2(__m128i x)
+{
+	return _mm_srai_epi32(_mm_unpackhi_epi16(x, x), 16);
+}
+
+FIXED_SSE2 static size_t fixedToDoubleSse2(const fixed16* f, double* out, size_t n)
+{
+	__m128d scale = _mm_set1_pd(1.0 / 256);
+	size_t i;
+	
+	for (i = 0; i + 8 <= n; i += 8) {
+		__m128i x = _mm_loadu_si128((const __m128i*) (f + i));
+		__m128i lo = fixedLowToIntsSse2(x);
+		__m128i hi = fixedHighToIntsSse2(x);
+		_mm_storeu_pd(out + i, _mm_mul_pd(_mm_cvtepi32_pd(lo), scale));
+		_mm_storeu_pd(out + i + 2, _mm_mul_pd(_mm_cvtepi32_pd(_mm_unpackhi_epi64(lo, lo)), scale));
+		_mm_storeu_pd(out + i + 4, _mm_mul_pd(_mm_cvtepi32_pd(hi), scale));
+		_mm_storeu_pd(out + i + 6, _mm_mul_pd(_mm_cvtepi32_pd(_mm_unpackhi_epi64(hi, hi)), scale));
+	}
+	return i;
+}
+
+FIXED_AVX2 static size_t fixedToDoubleAvx2(const fixed16* f, double* out, size_t n)
+{
+	__m256d scale = _mm256_set1_pd(1.0 / 256);
+	size_t i;
+	
+	for (i = 0; i + 8 <= n; i += 8) {
+		__m256i x = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*) (f + i)));
+		_mm256_storeu_pd(out + i, _mm256_mul_pd(_mm256_cvtepi32_pd(_mm256_castsi256_si128(x)), scale));
+		_mm256_storeu_pd(out + i + 4, _mm256_mul_pd(_mm256_cvtepi32_pd(_mm256_extracti128_si256(x, 1)), scale));
+	}
+	return i;
+}
+
+FIXED_SSE2 static size_t fixedToFloatSse2(const fixed16* f, float* out, size_t n)
+{
+	__m128 scale = _mm_set1_ps(1.0f / 256);
+	size_t i;
+	
+	for (i = 0; i + 8 <= n; i += 8) {
+		__m128i x = _mm_loadu_si128((const __m128i*) (f + i));
+		_mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(fixedLowToIntsSse2(x)), scale));
+		_mm_storeu_ps(out + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(fixedHighToIntsSse2(x)), scale));
+	}
+	return i;
+}
+
+FIXED_AVX2 static size_t fixedToFloatAvx2(const fixed16* f, float* out, size_t n)
+{
+	__m256 scale = _mm256_set1_ps(1.0f / 256);
+	size_t i;
+	
+	for (i = 0; i + 8 <= n; i += 8) {
+		__m256i x = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*) (f + i)));
+		_mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_cvtepi32_ps(x), scale));
+	}
+	return i;
+}
+
+FIXED_SSE2 static size_t fixed32ToDoubleSse2(const int32_t* f, double* out, size_t n)
+{
+	__m128d scale = _mm_set1_pd(1.0 / 65536);
+	size_t i;
+	
+	for (i = 0; i + 4 <= n; i += 4) {
+		__m128i x = _mm_loadu_si128((const __m128i*) (f + i));
+		_mm_storeu_pd(out + i, _mm_mul_pd(_mm_cvtepi32_pd(x), scale));
+		_mm_storeu_pd(out + i + 2, _mm_mul_pd(_mm_cvtepi32_pd(_mm_unpackhi_epi64(x, x)), scale));
+	}
+	return i;
+}
+
+FIXED_AVX2 static size_t fixed32ToDoubleAvx2(const int32_t* f, double* out, size_t n)
+{
+	__m256d scale = _mm256_set1_pd(1.0 / 65536);
+	size_t i;
+	
+	for (i = 0; i + 4 <= n; i += 4)
+		_mm256_storeu_pd(out + i, _mm256_mul_pd(_mm256_cvtepi32_pd(_mm_loadu_si128((const __m128i*) (f + i))), scale));
+	return i;
+}
+
+// Calls the kernel for the level the CPU supports, and returns how many elements it did.
+#define FIXED_KERNEL(name, ...)  \
+	(FixedArrayLevel() == 2 ? name##Avx2(__VA_ARGS__) : FixedArrayLevel() == 1 ? name##Sse2(__VA_ARGS__) : 0)
+#else
+#define FIXED_KERNEL(name, ...)  0
+#endif
+
+void fixedToDoubleArray(const fixed16* f, double* out, size_t n)
+{
+	size_t i;
+	
+	for (i = FIXED_KERNEL(fixedToDouble, f, out, n); i < n; i++)
+		out[i] = f[i] / 256.0;
+}
+
+void fixedToFloatArray(const fixed16* f, float* out, size_t n)
+{
+	size_t i;
+	
+	for (i = FIXED_KERNEL(fixedToFloat, f, out, n); i < n; i++)
+		out[i] = f[i] / 256.0f;
+}
+
+void fixed32ToDoubleArray(const int32_t* f, double* out, size_t n)
+{
+	size_t i;
+	
+	for (i = FIXED_KERNEL(fixed32ToDouble, f, out, n); i < n; i++)
+		out[i] = f[i] / 65536.0;
+}
+
+void fixedIntegralArray(const fixed16* f, signed char* out, size_t n)
+{
+	size_t i;
+	
+	for (i = FIXED_KERNEL(fixedBytes, FIXED_OP_INTEGRAL, f, out, 0, n); i < n; i++)
+		out[i] = fixedIntegral(f[i]);
+}
+
+void fixedTruncToByteArray(const fixed16* f, signed char* out, size_t n)
+{
+	size_t i;
+	
+	for (i = FIXED_KERNEL(fixedBytes, FIXED_OP_TRUNC, f, out, 0, n); i < n; i++)
+		out[i] = fixedTruncToByte(f[i]);
+}
+
+void fixedRoundToByteArray(const fixed16* f, signed char* out, size_t n)
+{
+	size_t i;
+	
+	for (i = FIXED_KERNEL(fixedBytes, FIXED_OP_ROUND, f, out, 0, n); i < n; i++)
+		out[i] = fixedRoundToByte(f[i]);
+}
+
+void fixedRoundToTenthsArray(const fixed16* f, signed char* units, unsigned char* tenths, size_t n)
+{
+	size_t i;
+	
+	for (i = FIXED_KERNEL(fixedBytes, FIXED_OP_TENTHS, f, units, tenths, n); i < n; i++)
+		fixedRoundToTenths(f[i], units[i], tenths[i]);
+}
+
+#ifdef TEST_FIXED32
+/*	Checks the kernels against the per-element functions, on a PC, and times them:
+		g++ -x c++ -O2 -DTEST_FIXED32 fixed32.c -o fixed32test
+	Every fixed16 value is converted at each level the CPU has, at every length up to a few vectors
+	and at odd offsets, so the leftovers are covered too.  The saturating operations are checked
+	against plain 64-bit arithmetic, and their results go through the array conversion at each level
+	as well.  Exits with 1 on any difference.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define TEST_COUNT  (65536 + 64)
+
+static fixed16 testIn[TEST_COUNT];
+static int32_t testIn32[TEST_COUNT];
+
+struct TestOut {
+	double d[TEST_COUNT];
+	float fl[TEST_COUNT];
+	double d32[TEST_COUNT];
+	signed char integral[TEST_COUNT];
+	signed char trunc[TEST_COUNT];
+	signed char round[TEST_COUNT];
+	signed char units[TEST_COUNT];
+	unsigned char tenths[TEST_COUNT];
+};
+
+// Returns n / d, rounded to nearest with halves away from zero, like the saturating operations.
+static int64_t testRoundedQuotient(int64_t n, int64_t d)
+{
+	int64_t q = n / d;
+	int64_t r = n % d;
+	
+	if (2 * (r < 0 ? -r : r) >= (d < 0 ? -d : d))
+		q += ((n < 0) != (d < 0)) ? -1 : 1;
+	return q;
+}
+
+static void testConvert(const fixed16* in, const int32_t* in32, TestOut* out, size_t n)
+{
+	fixedToDoubleArray(in, out->d, n);
+	fixedToFloatArray(in, out->fl, n);
+	fixed32ToDoubleArray(in32, out->d32, n);
+	fixedIntegralArray(in, out->integral, n);
+	fixedTruncToByteArray(in, out->trunc, n);
+	fixedRoundToByteArray(in, out->round, n);
+	fixedRoundToTenthsArray(in, out->units, out->tenths, n);
+}
+
+int main(int argc, char* argv[])
+{
+	static TestOut expected, got;
+	unsigned long failures = 0;
+	size_t i, n, offset;
+	int level;
+	int best = FixedArrayLevel();
+	
+	srand(1);
+	for (i = 0; i < TEST_COUNT; i++) {
+		testIn[i] = (fixed16) i;
+		testIn32[i] = (int32_t) (((uint32_t) rand() << 16) ^ (uint32_t) rand());
+	}
+	testIn32[0] = INT32_MIN;
+	testIn32[1] = INT32_MAX;
+	
+	// The scalar results, element by element.
+	fixedArrayLevel = 0;
+	testConvert(testIn, testIn32, &expected, TEST_COUNT);
+	
+	for (level = 1; level <= best; level++) {
+		fixedArrayLevel = level;
+		for (n = 0; n <= TEST_COUNT; n = (n < 100) ? n + 1 : n + 65436) {
+			for (offset = 0; offset < 3 && offset + n <= TEST_COUNT; offset++) {
+				// Filled first, to catch writing past the end.
+				memset(&got, 0x5A, sizeof(got));
+				testConvert(testIn + offset, testIn32 + offset, &got, n);
+				
+				#define TEST_FIELD(field)  \
+					if (memcmp(got.field, expected.field + offset, n * sizeof(got.field[0])) != 0 \
+							|| (n < TEST_COUNT && *(unsigned char*) &got.field[n] != 0x5A)) { \
+						if (failures++ < 10) \
+							printf("%s: " #field " differs, length %u, offset %u\n", \
+								fixedArrayKernelName(), (unsigned int) n, (unsigned int) offset); \
+					}
+				TEST_FIELD(d)
+				TEST_FIELD(fl)
+				TEST_FIELD(d32)
+				TEST_FIELD(integral)
+				TEST_FIELD(trunc)
+				TEST_FIELD(round)
+				TEST_FIELD(units)
+				TEST_FIELD(tenths)
+			}
+		}
+	}
+	
+	// The saturating operations, on operands of every size, against 64-bit results clamped to 32 bits.
+	// The first few thousand are small multiples of 1/65536 and 1/2, which make plenty of halves to round.
+	static int32_t satResults[TEST_COUNT];
+	static double satDoubles[TEST_COUNT];
+	for (i = 0; i < TEST_COUNT; i++) {
+		int32_t a = testIn32[i] >> ((i / 4) % 32);
+		int32_t b = testIn32[(i * 7 + 3) % TEST_COUNT] >> ((i / 128) % 32);
+		if (i < 4096) {
+			a = (int32_t) (i / 4 % 32) - 16;
+			b = ((int32_t) (i / 128) - 16) * 0x8000;
+		}
+		int64_t exact;
+		fixed32 result;
+		const char* name;
+		
+		switch (i % 4) {
+			case 0:
+				name = "fixed32MulSat";
+				exact = testRoundedQuotient((int64_t) a * b, 65536);
+				result = fixed32MulSat(a, b);
+				break;
+			case 1:
+				name = "fixed32DivSat";
+				if (b == 0)
+					exact = (a < 0) ? INT64_MIN : (a > 0) ? INT64_MAX : 0;
+				else
+					exact = testRoundedQuotient((int64_t) a * 65536, b);
+				result = fixed32DivSat(a, b);
+				break;
+			case 2:
+				name = "fixed32AddSat";
+				exact = (int64_t) a + b;
+				result = fixed32AddSat(a, b);
+				break;
+			default:
+				name = "fixed32SubSat";
+				exact = (int64_t) a - b;
+				result = fixed32SubSat(a, b);
+				break;
+		}
+		
+		if (exact > INT32_MAX)
+			exact = INT32_MAX;
+		else if (exact < INT32_MIN)
+			exact = INT32_MIN;
+		if (result != exact) {
+			if (failures++ < 10)
+				printf("%s(0x%08X, 0x%08X) gave 0x%08lX, not 0x%08lX\n", name,
+					(unsigned int) a, (unsigned int) b, (unsigned long) (uint32_t) result, (unsigned long) (uint32_t) exact);
+		}
+		satResults[i] = (int32_t) result;
+	}
+	for (level = 0; level <= best; level++) {
+		fixedArrayLevel = level;
+		fixed32ToDoubleArray(satResults, satDoubles, TEST_COUNT);
+		for (i = 0; i < TEST_COUNT; i++) {
+			if (satDoubles[i] != satResults[i] / 65536.0) {
+				if (failures++ < 10)
+					printf("%s: saturated result %u converts differently\n", fixedArrayKernelName(), (unsigned int) i);
+				break;
+			}
+		}
+	}
+	
+	// Throughput, in millions of elements a second.
+	int reps = argc > 1 ? atoi(argv[1]) : 2000;
+	for (level = 0; level <= best; level++) {
+		fixedArrayLevel = level;
+		clock_t begin = clock();
+		for (int rep = 0; rep < reps; rep++)
+			testConvert(testIn, testIn32, &got, 65536);
+		double seconds = (double) (clock() - begin) / CLOCKS_PER_SEC;
+		printf("%-7s %8.0f M elements/s, all seven conversions\n", fixedArrayKernelName(),
+			65536.0 * reps / 1e6 / (seconds > 0 ? seconds : 1e-9));
+	}
+	
+	printf(failures ? "%lu failures\n" : "all levels match the per-element functions, and the saturating operations are exact\n", failures);
+	return failures ? 1 : 0;
+}
+#endif
+#endif
@@ -28,6 +28,15 @@
 		
 	- Similarly, you can divide a fixed-point by a plain integer directly
 		to get a fixed-point result.
+		
+	- Or, use fixed32Mul(), which splits the operands into integral and
+		fractional halves so the product can't overflow along the way.
+		
+	- For results that might be out of range, use the saturating functions
+		at the bottom, which need fixed32.c.
+		
+	- Convert between 8.8 and 16.16 only explicitly, with fixed32FromFixed16()
+		and fixed16FromFixed32().
 */
 
 #ifndef __FIXED32_H
@@ -38,6 +47,11 @@
 
 typedef signed long fixed32;
 
+// The largest and smallest values; the saturating functions below stop here.
+// (Written so the minimum is still negative where long is 64 bits.)
+#define FIXED32_MAX  ((fixed32) 0x7FFFFFFF)
+#define FIXED32_MIN  ((fixed32) (-0x7FFFFFFF - 1))
+
 
 // Returns b converted to fixed-point, with no fractional part.
 inline fixed32 fixed32FromShort(signed short b)
@@ -45,7 +59,7 @@ inline fixed32 fixed32FromShort(signed short b)
 	return ((fixed32) b) << 16;
 }
 // This version is more efficient.
-#define FIXED32_FROM_SHORT(b)  (b << 16)
+#define FIXED32_FROM_SHORT(b)  ((fixed32) (b) << 16)
 
 // Returns b as a fixed-point fraction, with no integral part.
 inline fixed32 fixed32FracFromShort(unsigned short b)
@@ -53,15 +67,15 @@ inline fixed32 fixed32FracFromShort(unsigned short b)
 	return (fixed32) b;
 }
 // This version is more efficient.
-#define FIXED32_FRAC_FROM_SHORT(b)  (b)
+#define FIXED32_FRAC_FROM_SHORT(b)  ((fixed32) (b))
 
 inline fixed32 makeFixed32(signed short integral, unsigned short fractional)
 {
 	return (((fixed32) integral) << 16) | ((fixed32) fractional);
 }
 // This version is more efficient.
-#define MAKE_FIXED32(result, integral, fractional)  (((fixed32) integral) << 16) | ((fixed32) fractional)
-#define MAKE_FIXED32_CONST(integral, fractional)  (integral * 256 + fractional)
+#define MAKE_FIXED32(result, integral, fractional)  ((result) = ((fixed32) (integral) << 16) | (fixed32) (unsigned short) (fractional))
+#define MAKE_FIXED32_CONST(integral, fractional)  ((integral) * 65536 + (fractional))
 
 inline fixed32 fixed32FromFixed16(fixed16 f)
 {
@@ -80,7 +94,7 @@ inline void fixed32IntegralTo(fixed32 f, signed short& i)
 	i = (signed short) (f >> 16);
 }
 // This version is more efficient.
-#define FIXED32_INTEGRAL_TO(f, i)  ((unsigned short) (f >> 16))
+#define FIXED32_INTEGRAL_TO(f, i)  ((i) = (signed short) ((f) >> 16))
 
 // Returns the fractional part of f times 65536.
 inline void fixed32FracTo(fixed32 f, unsigned short& frac)
@@ -88,7 +102,7 @@ inline void fixed32FracTo(fixed32 f, unsigned short& frac)
 	frac = (unsigned short) (f & 0xFFFF);
 }
 // This version is more efficient.
-#define FIXED32_FRAC_TO(f, frac)  ((unsigned short) (f & 0xFFFF))
+#define FIXED32_FRAC_TO(f, frac)  ((frac) = (unsigned short) ((f) & 0xFFFF))
 
 // Return f truncated to an integer.
 inline signed short fixed32Integral(fixed32 f)
@@ -96,7 +110,7 @@ inline signed short fixed32Integral(fixed32 f)
 	return f >> 16;
 }
 // More efficient.
-#define FIXED32_INTEGRAL(f)  (f >> 16)
+#define FIXED32_INTEGRAL(f)  ((f) >> 16)
 
 // Returns f truncated to an integer.
 inline fixed32 fixedTrunc(fixed32 f)
@@ -116,10 +130,94 @@ inline signed short fixed32RoundToByte(fixed32 f)
 	return (signed short)((f + 0x00008000) >> 16);
 }
 
+// Returns a * b, rounded down.
+// There's no 64-bit intermediate, so this adds up the products of the
+// integral and fractional halves, each of which fits in 32 bits.
+// The result is exact as long as it's in range.
+inline fixed32 fixed32Mul(fixed32 a, fixed32 b)
+{
+	signed short ai = a >> 16;
+	unsigned short af = a & 0xFFFF;
+	signed short bi = b >> 16;
+	unsigned short bf = b & 0xFFFF;
+	
+	fixed32 result = ((fixed32) ai * bi) << 16;
+	result += (fixed32) ai * bf;
+	result += (fixed32) af * bi;
+	result += ((unsigned long) af * bf) >> 16;
+	return result;
+}
+
 // Return 1/f.
 inline fixed32 fixed32Reciprocal(fixed32 f)
 {
 	return ((1 << 16) / f) << 16;
 }
 
+// Saturating arithmetic.
+// These return FIXED32_MAX or FIXED32_MIN instead of wrapping around when the result is out of range.
+// Products and quotients are rounded to the nearest 1/65536, with halves rounded away from zero.
+
+inline fixed32 fixed32AddSat(fixed32 a, fixed32 b)
+{
+	fixed32 result = a + b;
+	
+	// Overflow only happens when both operands have the sign the result doesn't.
+	if (((a ^ result) & (b ^ result)) < 0)
+		return (a < 0) ? FIXED32_MIN : FIXED32_MAX;
+#ifndef _BOOSTC
+	// On a PC the sum doesn't wrap, so it just has to be clamped.
+	if (result > FIXED32_MAX)
+		return FIXED32_MAX;
+	if (result < FIXED32_MIN)
+		return FIXED32_MIN;
+#endif
+	return result;
+}
+
+inline fixed32 fixed32SubSat(fixed32 a, fixed32 b)
+{
+	fixed32 result = a - b;
+	
+	// Overflow only happens when the operands' signs differ, and the result's differs from a's.
+	if (((a ^ b) & (a ^ result)) < 0)
+		return (a < 0) ? FIXED32_MIN : FIXED32_MAX;
+#ifndef _BOOSTC
+	if (result > FIXED32_MAX)
+		return FIXED32_MAX;
+	if (result < FIXED32_MIN)
+		return FIXED32_MIN;
+#endif
+	return result;
+}
+
+// These are in fixed32.c, for the PIC and for a PC.
+fixed32 fixed32MulSat(fixed32 a, fixed32 b);
+
+// Division by zero returns FIXED32_MAX or FIXED32_MIN, by the sign of a (or 0 if a is 0).
+fixed32 fixed32DivSat(fixed32 a, fixed32 b);
+
+
+#ifndef _BOOSTC
+// Whole arrays at once, on a PC (e.g. for logged readings); these are in fixed32.c too.
+// Each gives exactly what the per-element function does, using SSE2 or AVX2 if the CPU has them.
+// long is 64 bits there, so 16.16 values are passed as the 32 bits the PIC stores.
+#include <stddef.h>
+#include <stdint.h>
+
+// f / 256.0, or f / 65536.0, which are exact.
+void fixedToDoubleArray(const fixed16* f, double* out, size_t n);
+void fixedToFloatArray(const fixed16* f, float* out, size_t n);
+void fixed32ToDoubleArray(const int32_t* f, double* out, size_t n);
+
+// fixedIntegral(), fixedTruncToByte(), fixedRoundToByte() and fixedRoundToTenths() of each element.
+void fixedIntegralArray(const fixed16* f, signed char* out, size_t n);
+void fixedTruncToByteArray(const fixed16* f, signed char* out, size_t n);
+void fixedRoundToByteArray(const fixed16* f, signed char* out, size_t n);
+void fixedRoundToTenthsArray(const fixed16* f, signed char* units, unsigned char* tenths, size_t n);
+
+// What the functions above use: "avx2", "sse2" or "scalar".
+const char* fixedArrayKernelName(void);
+#endif
+
 #endif
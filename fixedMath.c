@@ -0,0 +1,341 @@
+/* fixedMath.c
+    Copyright (c) 2026 by Timothy J. Weber, tw@timothyweber.org.
+
+	Square roots, reciprocals, trig and exponentials for fixed16 and fixed32.
+*/
+
+#include <system.h>
+
+#include "fixedMath.h"
+
+
+// Returns 1/d in Q1.15, where d = m / 65536, and m has its top bit set (so d is in [0.5, 1)).
+// Starts from the best linear approximation, 48/17 - 32/17 d, which is within 1/17,
+// and then squares the error twice with Newton-Raphson: x' = x (2 - d x).
+unsigned long reciprocalQ15(unsigned short m)
+{
+	if (m == 0x8000)
+		// Exactly 0.5; the only case that doesn't fit in 16 bits.
+		return 0x10000;
+		
+	unsigned short x = 92521 - (((unsigned long) m * 61681) >> 16);  // 48/17 - 32/17 d, in Q15
+	unsigned char i;
+	for (i = 0; i < 2; i++) {
+		// d x in Q15 is at most a little over 1.
+		unsigned short dx = ((unsigned long) m * x) >> 16;
+		x = ((unsigned long) x * (0x10000 - dx)) >> 15;
+	}
+	return x;
+}
+
+fixed16 fixedRecip(fixed16 f)
+{
+	if (f == 0)
+		return FIXED_MAX;
+		
+	unsigned short m = (f < 0) ? -(signed long) f : f;
+	
+	// Normalize, so the top bit is set.
+	unsigned char s = 0;
+	while (!(m & 0x8000)) {
+		m <<= 1;
+		++s;
+	}
+	
+	// f = d 2^(8 - s), so 1/f = (1/d) 2^(s - 8), which is the Q15 reciprocal shifted right by 15 - s
+	// to get 8 fractional bits.
+	unsigned long r = reciprocalQ15(m);
+	s = 15 - s;
+	if (s)
+		r = (r + (1 << (s - 1))) >> s;
+	if (r > 0x7FFF)
+		return (f < 0) ? FIXED_MIN : FIXED_MAX;
+		
+	return (f < 0) ? -(fixed16) r : (fixed16) r;
+}
+
+fixed32 fixed32Recip(fixed32 f)
+{
+	if (f == 0)
+		return FIXED32_MAX;
+		
+	unsigned long m = (f < 0) ? -(unsigned long) f : f;
+	
+	// Normalize, so the top bit is set.
+	unsigned char s = 0;
+	while (!(m & 0x80000000)) {
+		m <<= 1;
+		++s;
+	}
+	
+	// f = d 2^(16 - s), so 1/f = (1/d) 2^(s - 16), which is the Q15 reciprocal shifted by s - 15
+	// to get 16 fractional bits.
+	unsigned short hi = (m + 0x8000) >> 16;
+	unsigned long r;
+	if (hi == 0)
+		// Rounding carried out of the top - m was 0xFFFF8000 or more, so d is 1.
+		r = 0x8000;
+	else
+		r = reciprocalQ15(hi);
+		
+	if (s < 15) {
+		s = 15 - s;
+		r = (r + (1 << (s - 1))) >> s;
+	} else if (s > 15) {
+		s -= 15;
+		// r is at least 0x8000, so this overflows for s >= 16.
+		if (s >= 16 || (r << s) > 0x7FFFFFFF)
+			return (f < 0) ? FIXED32_MIN : FIXED32_MAX;
+		r <<= s;
+	}
+	
+	return (f < 0) ? -(fixed32) r : (fixed32) r;
+}
+
+// Returns the square root of the number whose bits are given, two at a time, from the top of n,
+// followed by zeros; steps is the number of pairs of bits (so, the number of result bits).
+// Uses the digit-by-digit method, and rounds to nearest.
+unsigned long sqrtDigits(unsigned long n, unsigned char steps)
+{
+	unsigned long root = 0;
+	unsigned long rem = 0;
+	unsigned long trial;
+	
+	while (steps--) {
+		rem = (rem << 2) | (n >> 30);
+		n <<= 2;
+		trial = (root << 2) | 1;
+		root <<= 1;
+		if (rem >= trial) {
+			rem -= trial;
+			root |= 1;
+		}
+	}
+	
+	// rem = n - root^2, and (root + 1/2)^2 = root^2 + root + 1/4.
+	if (rem > root)
+		++root;
+	return root;
+}
+
+fixed16 fixedSqrt(fixed16 f)
+{
+	if (f <= 0)
+		return 0;
+		
+	// sqrt(f / 256) * 256 = sqrt(f * 256).
+	return (fixed16) sqrtDigits((unsigned long) f << 8, 16);
+}
+
+fixed32 fixed32Sqrt(fixed32 f)
+{
+	if (f <= 0)
+		return 0;
+		
+	// sqrt(f / 65536) * 65536 = sqrt(f * 65536), a 48-bit number: f followed by 16 zero bits.
+	return (fixed32) sqrtDigits(f, 24);
+}
+
+// atan(2^-i) for each CORDIC iteration i, in 1/65536ths of a binary radian
+// (so 2^32 is a full turn), as 4 bytes each, LSB first.
+#define CORDIC_STEPS_16  14
+#define CORDIC_STEPS_32  20
+rom unsigned char* cordicAtan = {
+	0x00, 0x00, 0x00, 0x20, 0x1E, 0x05, 0xE4, 0x12,
+	0x5B, 0x38, 0xFB, 0x09, 0xD4, 0x11, 0x11, 0x05,
+	0x43, 0x0D, 0x8B, 0x02, 0xE1, 0xD7, 0x45, 0x01,
+	0x1E, 0xF6, 0xA2, 0x00, 0x55, 0x7C, 0x51, 0x00,
+	0x53, 0xBE, 0x28, 0x00, 0x2F, 0x5F, 0x14, 0x00,
+	0x98, 0x2F, 0x0A, 0x00, 0xCC, 0x17, 0x05, 0x00,
+	0xE6, 0x8B, 0x02, 0x00, 0xF3, 0x45, 0x01, 0x00,
+	0xFA, 0xA2, 0x00, 0x00, 0x7D, 0x51, 0x00, 0x00,
+	0xBE, 0x28, 0x00, 0x00, 0x5F, 0x14, 0x00, 0x00,
+	0x30, 0x0A, 0x00, 0x00, 0x18, 0x05, 0x00, 0x00
+};
+
+inline signed long CordicAtan(unsigned char i)
+{
+	signed long result;
+	unsigned char* p = (unsigned char*) &result;  // BoostC is little-endian, like the table.
+	unsigned char j = i << 2;
+	p[0] = cordicAtan[j];
+	p[1] = cordicAtan[j + 1];
+	p[2] = cordicAtan[j + 2];
+	p[3] = cordicAtan[j + 3];
+	return result;
+}
+
+// The CORDIC gain after each number of iterations, inverted.
+#define CORDIC_K_Q14  9949
+#define CORDIC_K_Q29  326016437
+
+// CORDIC only converges within about 90 degrees of 0, so this rotates the other half by 180.
+// Returns true if the results need to be negated, and leaves the angle to rotate by in z.
+inline char CordicStartAngle(unsigned short angle, signed long* z)
+{
+	bit flip = ((angle + ANGLE_90) & ANGLE_180) != 0;
+	if (flip)
+		angle += ANGLE_180;
+	*z = (signed long) (signed short) angle << 16;
+	return flip;
+}
+
+// Computes the sine and cosine of angle in Q14, with 16-bit arithmetic apart from the angle.
+void sinCosQ14(unsigned short angle, signed short* sinResult, signed short* cosResult)
+{
+	signed long z;
+	bit flip = CordicStartAngle(angle, &z);
+	signed short x = CORDIC_K_Q14;
+	signed short y = 0;
+	signed short dx;
+	unsigned char i;
+	
+	for (i = 0; i < CORDIC_STEPS_16; i++) {
+		dx = x >> i;
+		if (z >= 0) {
+			x -= y >> i;
+			y += dx;
+			z -= CordicAtan(i);
+		} else {
+			x += y >> i;
+			y -= dx;
+			z += CordicAtan(i);
+		}
+	}
+	
+	if (flip) {
+		x = -x;
+		y = -y;
+	}
+	*sinResult = y;
+	*cosResult = x;
+}
+
+void fixedSinCos(unsigned short angle, fixed16* sinResult, fixed16* cosResult)
+{
+	signed short s, c;
+	sinCosQ14(angle, &s, &c);
+	*sinResult = (s + 32) >> 6;
+	*cosResult = (c + 32) >> 6;
+}
+
+void fixed32SinCos(unsigned short angle, fixed32* sinResult, fixed32* cosResult)
+{
+	// The same, but in Q29.
+	signed long z;
+	bit flip = CordicStartAngle(angle, &z);
+	signed long x = CORDIC_K_Q29;
+	signed long y = 0;
+	signed long dx;
+	unsigned char i;
+	
+	for (i = 0; i < CORDIC_STEPS_32; i++) {
+		dx = x >> i;
+		if (z >= 0) {
+			x -= y >> i;
+			y += dx;
+			z -= CordicAtan(i);
+		} else {
+			x += y >> i;
+			y -= dx;
+			z += CordicAtan(i);
+		}
+	}
+	
+	if (flip) {
+		x = -x;
+		y = -y;
+	}
+	*sinResult = (y + (1 << 12)) >> 13;
+	*cosResult = (x + (1 << 12)) >> 13;
+}
+
+unsigned short fixedAtan2(signed long y, signed long x)
+{
+	// Work in the first quadrant, and reflect the result afterwards.
+	bit xNegative = x < 0;
+	bit yNegative = y < 0;
+	unsigned long ux = xNegative ? -(unsigned long) x : x;
+	unsigned long uy = yNegative ? -(unsigned long) y : y;
+	
+	if (ux == 0 && uy == 0)
+		return 0;
+		
+	// Scale so the larger is between 2^28 and 2^29:
+	// small enough to leave room for the CORDIC gain, and large enough for precision.
+	while (ux >= 0x20000000 || uy >= 0x20000000) {
+		ux >>= 1;
+		uy >>= 1;
+	}
+	while (ux < 0x10000000 && uy < 0x10000000) {
+		ux <<= 1;
+		uy <<= 1;
+	}
+	
+	// Rotate the vector down to the x axis, adding up the angle it took.
+	signed long sx = ux;
+	signed long sy = uy;
+	signed long dx;
+	signed long z = 0;
+	unsigned char i;
+	
+	for (i = 0; i < CORDIC_STEPS_32; i++) {
+		dx = sx >> i;
+		if (sy > 0) {
+			sx += sy >> i;
+			sy -= dx;
+			z += CordicAtan(i);
+		} else {
+			sx -= sy >> i;
+			sy += dx;
+			z -= CordicAtan(i);
+		}
+	}
+	
+	unsigned short angle = (z + 0x8000) >> 16;
+	if (xNegative)
+		angle = ANGLE_180 - angle;
+	if (yNegative)
+		angle = -angle;
+	return angle;
+}
+
+// 2^(i/16) - 1, for i from 0 to 15, in Q16.  (2^(16/16) - 1 = 1 doesn't fit, so it's handled separately.)
+rom unsigned char* exp2Lo = {
+	0x00, 0x56, 0x2C, 0x88, 0x70, 0xEA, 0xFE, 0xB0, 0x0A, 0x11, 0xCE, 0x49, 0x8A, 0x9A, 0x82, 0x4B
+};
+rom unsigned char* exp2Hi = {
+	0x00, 0x0B, 0x17, 0x23, 0x30, 0x3D, 0x4B, 0x5A, 0x6A, 0x7A, 0x8A, 0x9C, 0xAE, 0xC1, 0xD5, 0xEA
+};
+
+fixed32 fixedExp2(fixed16 x)
+{
+	signed char n = FIXED_INTEGRAL(x);  // rounds down, so the fraction is positive
+	unsigned char frac = x & 0xFF;
+	
+	if (n >= 15)
+		return FIXED32_MAX;
+	if (n < -17)
+		return 0;
+		
+	// Interpolate 2^frac - 1 between table entries, in Q16.
+	unsigned char j = frac >> 4;
+	unsigned char t = frac & 0x0F;
+	unsigned short entry;
+	unsigned long lo, hi;
+	MAKESHORT(entry, exp2Lo[j], exp2Hi[j]);
+	lo = entry;
+	if (j == 15)
+		hi = 0x10000;
+	else {
+		MAKESHORT(entry, exp2Lo[j + 1], exp2Hi[j + 1]);
+		hi = entry;
+	}
+	unsigned long m = 0x10000 + lo + (((hi - lo) * t + 8) >> 4);  // 2^frac, in Q16
+	
+	// Then scale by 2^n; the result is already in 16.16.
+	if (n >= 0)
+		return (fixed32) (m << n);
+	n = -n;
+	return (fixed32) ((m + ((unsigned long) 1 << (n - 1))) >> n);
+}
@@ -0,0 +1,80 @@
+/* fixedMath.h
+    Copyright (c) 2026 by Timothy J. Weber, tw@timothyweber.org.
+
+	Square roots, reciprocals, trig and exponentials for fixed16 and fixed32,
+	without going through fpmath.
+	
+	Angles are "binary radians": an unsigned short where 0x10000 is a full turn,
+	so 0x4000 = 90 degrees, and wraparound is free.
+	
+	Error bounds below were measured against double-precision results over the whole input range
+	(every fixed16 value, or a dense sample of fixed32 values), and are in units of the result's
+	last place (LSB) unless stated otherwise.
+	Costs are given as the work done per call, since cycle counts vary by chip and compiler settings;
+	none of these use a divide.
+*/
+
+#ifndef __FIXED_MATH_H
+#define __FIXED_MATH_H
+
+#include "fixed16.h"
+#include "fixed32.h"
+
+
+// Full-turn angle constants, in binary radians.
+#define ANGLE_90  0x4000
+#define ANGLE_180  0x8000
+#define ANGLE_270  0xC000
+
+// Returns 1/f, by Newton-Raphson iteration on f normalized to [0.5, 1).
+// Saturates to FIXED_MAX or FIXED_MIN when the result is out of range, including for f == 0.
+// fixedRecip: within 1 LSB.
+// fixed32Recip: within 1 part in 2^14 (only the top 16 bits of f are used), or 2 LSB for results below 1/2.
+// Cost: normalizing shifts, then 5 16x16 multiplies.
+fixed16 fixedRecip(fixed16 f);
+fixed32 fixed32Recip(fixed32 f);
+
+// Returns the square root of f, rounded to the nearest LSB.  Returns 0 for f <= 0.
+// Exact (the correctly-rounded result).
+// Cost: 16 (fixed16) or 24 (fixed32) shift-and-subtract steps.
+fixed16 fixedSqrt(fixed16 f);
+fixed32 fixed32Sqrt(fixed32 f);
+
+// Computes the sine and cosine of angle, by CORDIC.
+// Both are within 1 LSB.
+// Cost: 14 iterations of 16-bit shifts and adds for fixedSinCos, 20 iterations of 32-bit ones for fixed32SinCos.
+void fixedSinCos(unsigned short angle, fixed16* sinResult, fixed16* cosResult);
+void fixed32SinCos(unsigned short angle, fixed32* sinResult, fixed32* cosResult);
+
+inline fixed16 fixedSin(unsigned short angle)
+{
+	fixed16 s, c;
+	fixedSinCos(angle, &s, &c);
+	return s;
+}
+
+inline fixed16 fixedCos(unsigned short angle)
+{
+	fixed16 s, c;
+	fixedSinCos(angle, &s, &c);
+	return c;
+}
+
+// Returns the angle of the vector (x, y), by CORDIC.
+// x and y can be any fixed-point or integer type, as long as they're the same one.
+// Returns 0 for (0, 0).
+// Within 1 binary radian (0.0055 degrees).
+// Cost: scaling shifts, then 20 iterations of 32-bit shifts and adds.
+unsigned short fixedAtan2(signed long y, signed long x);
+
+// Returns 2 to the power x.
+// Saturates to FIXED32_MAX for x >= 15; small results are rounded to the nearest LSB, down to 0.
+// Within 1 part in 3900 for results of 1/2 and up (from interpolating in a 17-entry table);
+// smaller results are off by up to that much, plus half an LSB of rounding.
+// For more precision, and a 16.16 argument, see exp2_f32() in log.h.
+// Cost: one table interpolation and a shift.
+fixed32 fixedExp2(fixed16 x);
+
+
+#endif
+// __FIXED_MATH_H
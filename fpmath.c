@@ -1049,6 +1049,55 @@ asm
 	return xx;
 }
 
+single muladdfloat(single xx, single yy, single zz)
+{
+asm
+	{
+		MOVF	_xx,W
+		MOVWF	_FPbuff+3
+		MOVF	_xx+1,W
+		MOVWF	_FPbuff+2
+		MOVF	_xx+2,W
+		MOVWF	_FPbuff+1
+		MOVF	_xx+3,W
+		MOVWF	_FPbuff
+		MOVF	_yy,W
+		MOVWF	_FPbuff+10
+		MOVF	_yy+1,W
+		MOVWF	_FPbuff+9
+		MOVF	_yy+2,W
+		MOVWF	_FPbuff+8
+		MOVF	_yy+3,W
+		MOVWF	_FPbuff+7		
+	}
+	FPmath(5);
+	// The product is left in the A argument, so only zz has to be loaded.
+	asm
+	{
+		MOVF	_zz,W
+		MOVWF	_FPbuff+10
+		MOVF	_zz+1,W
+		MOVWF	_FPbuff+9
+		MOVF	_zz+2,W
+		MOVWF	_FPbuff+8
+		MOVF	_zz+3,W
+		MOVWF	_FPbuff+7		
+	}
+	FPmath(3);
+	asm
+	{
+		MOVF	_FPbuff+3,W
+		MOVWF	_xx
+		MOVF	_FPbuff+2,W
+		MOVWF	_xx+1
+		MOVF	_FPbuff+1,W
+		MOVWF	_xx+2
+		MOVF	_FPbuff,W
+		MOVWF	_xx+3
+	}
+	return xx;
+}
+
 single absfloat(single xx)
 {
 asm
@@ -1143,6 +1192,297 @@ TAGTB32Y:
 	return bb;
 }
 
+single recipfloat(single xx)
+{
+	// Load 1.0 straight into A, rather than copying it from a variable.
+asm
+	{
+		MOVLW	0x7F
+		MOVWF	_FPbuff
+		CLRF	_FPbuff+1
+		CLRF	_FPbuff+2
+		CLRF	_FPbuff+3
+		MOVF	_xx,W
+		MOVWF	_FPbuff+10
+		MOVF	_xx+1,W
+		MOVWF	_FPbuff+9
+		MOVF	_xx+2,W
+		MOVWF	_FPbuff+8
+		MOVF	_xx+3,W
+		MOVWF	_FPbuff+7		
+	}
+	FPmath(6);
+	asm
+	{
+		MOVF	_FPbuff+3,W
+		MOVWF	_xx
+		MOVF	_FPbuff+2,W
+		MOVWF	_xx+1
+		MOVF	_FPbuff+1,W
+		MOVWF	_xx+2
+		MOVF	_FPbuff,W
+		MOVWF	_xx+3
+	}
+	return xx;
+}
+
+single sqrtfloat(single xx)
+{
+// registers mapped into FPbuff:
+//	FPbuff		result exponent
+//	FPbuff+1..3	mantissa, most significant byte first; the radicand is shifted out of the top
+//	FPbuff+4..7	remainder
+//	FPbuff+8..11	root so far, times 4
+//	FPbuff+12	loop counter
+// FPbuff+14 and 15 aren't touched.
+	asm
+	{
+		// Zero, or negative (a domain error): the result is zero.
+		MOVF	_xx+3,W
+		BTFSC	_status,Z
+		GOTO	SQRT32Z
+		BTFSC	_xx+2,7
+		GOTO	SQRT32Z
+		
+		MOVF	_xx+2,W
+		MOVWF	_FPbuff+1
+		BSF		_FPbuff+1,7
+		MOVF	_xx+1,W
+		MOVWF	_FPbuff+2
+		MOVF	_xx,W
+		MOVWF	_FPbuff+3
+		
+		CLRF	_FPbuff+4
+		CLRF	_FPbuff+5
+		CLRF	_FPbuff+6
+		CLRF	_FPbuff+7
+		CLRF	_FPbuff+8
+		CLRF	_FPbuff+9
+		CLRF	_FPbuff+10
+		CLRF	_FPbuff+11
+		MOVLW	25
+		MOVWF	_FPbuff+12
+		
+		// The exponent is (EXP + 127) / 2, carrying into the 9th bit.
+		MOVLW	0x7F
+		ADDWF	_xx+3,W
+		MOVWF	_FPbuff
+		RRF		_FPbuff,F
+		
+		// With an odd exponent, the radicand starts with a single bit, not a pair.
+		BTFSS	_xx+3,0
+		GOTO	SQRT32L
+		GOTO	SQRT32H
+		
+//----- Bring the next two bits of the radicand into the remainder
+SQRT32L:
+		BCF		_status,C
+		RLF		_FPbuff+3,F
+		RLF		_FPbuff+2,F
+		RLF		_FPbuff+1,F
+		RLF		_FPbuff+7,F
+		RLF		_FPbuff+6,F
+		RLF		_FPbuff+5,F
+		RLF		_FPbuff+4,F
+SQRT32H:
+		BCF		_status,C
+		RLF		_FPbuff+3,F
+		RLF		_FPbuff+2,F
+		RLF		_FPbuff+1,F
+		RLF		_FPbuff+7,F
+		RLF		_FPbuff+6,F
+		RLF		_FPbuff+5,F
+		RLF		_FPbuff+4,F
+		
+//----- Subtract 4 * root + 1, if it fits
+		BSF		_FPbuff+11,0
+		MOVF	_FPbuff+11,W
+		SUBWF	_FPbuff+7,F
+		MOVF	_FPbuff+10,W
+		BTFSS	_status,C
+		INCFSZ	_FPbuff+10,W
+		SUBWF	_FPbuff+6,F
+		MOVF	_FPbuff+9,W
+		BTFSS	_status,C
+		INCFSZ	_FPbuff+9,W
+		SUBWF	_FPbuff+5,F
+		MOVF	_FPbuff+8,W
+		BTFSS	_status,C
+		INCFSZ	_FPbuff+8,W
+		SUBWF	_FPbuff+4,F
+		BTFSC	_status,C
+		GOTO	SQRT32ONE
+		
+		MOVF	_FPbuff+11,W
+		ADDWF	_FPbuff+7,F
+		MOVF	_FPbuff+10,W
+		BTFSC	_status,C
+		INCFSZ	_FPbuff+10,W
+		ADDWF	_FPbuff+6,F
+		MOVF	_FPbuff+9,W
+		BTFSC	_status,C
+		INCFSZ	_FPbuff+9,W
+		ADDWF	_FPbuff+5,F
+		MOVF	_FPbuff+8,W
+		BTFSC	_status,C
+		INCFSZ	_FPbuff+8,W
+		ADDWF	_FPbuff+4,F
+		
+		BCF		_FPbuff+11,0
+		BCF		_status,C
+		RLF		_FPbuff+11,F
+		RLF		_FPbuff+10,F
+		RLF		_FPbuff+9,F
+		RLF		_FPbuff+8,F
+		GOTO	SQRT32NEXT
+		
+SQRT32ONE:
+		BCF		_FPbuff+11,0
+		BCF		_status,C
+		RLF		_FPbuff+11,F
+		RLF		_FPbuff+10,F
+		RLF		_FPbuff+9,F
+		RLF		_FPbuff+8,F
+		BSF		_FPbuff+11,2
+		
+SQRT32NEXT:
+		DECFSZ	_FPbuff+12,F
+		GOTO	SQRT32L
+		
+//----- The root has 25 bits; the last one rounds the other 24, to nearest
+		BCF		_status,C
+		RRF		_FPbuff+8,F
+		RRF		_FPbuff+9,F
+		RRF		_FPbuff+10,F
+		RRF		_FPbuff+11,F
+		BCF		_status,C
+		RRF		_FPbuff+8,F
+		RRF		_FPbuff+9,F
+		RRF		_FPbuff+10,F
+		RRF		_FPbuff+11,F
+		BCF		_status,C
+		RRF		_FPbuff+8,F
+		RRF		_FPbuff+9,F
+		RRF		_FPbuff+10,F
+		RRF		_FPbuff+11,F
+		
+		BTFSS	_status,C
+		GOTO	SQRT32OK
+		INCF	_FPbuff+11,F
+		BTFSC	_status,Z
+		INCF	_FPbuff+10,F
+		BTFSC	_status,Z
+		INCF	_FPbuff+9,F
+		BTFSS	_status,Z
+		GOTO	SQRT32OK
+		BSF		_FPbuff+9,7
+		INCF	_FPbuff,F
+		
+SQRT32OK:
+		BCF		_FPbuff+9,7
+		MOVF	_FPbuff+11,W
+		MOVWF	_xx
+		MOVF	_FPbuff+10,W
+		MOVWF	_xx+1
+		MOVF	_FPbuff+9,W
+		MOVWF	_xx+2
+		MOVF	_FPbuff,W
+		MOVWF	_xx+3
+		GOTO	SQRT32END
+		
+SQRT32Z:
+		CLRF	_xx
+		CLRF	_xx+1
+		CLRF	_xx+2
+		CLRF	_xx+3
+SQRT32END:
+	}
+	return xx;
+}
+
+signed char cmpfloat(single xx, single yy)
+{
+	signed char r = 0;
+	asm
+	{
+		// Anything with a zero exponent is zero, whatever its other bits.
+		MOVF	_xx+3,W
+		BTFSC	_status,Z
+		GOTO	CMP32XZ
+		MOVF	_yy+3,W
+		BTFSC	_status,Z
+		GOTO	CMP32YZ
+		
+		MOVF	_yy+2,W
+		XORWF	_xx+2,W
+		ANDLW	0x80
+		BTFSS	_status,Z
+		GOTO	CMP32YZ
+		
+		// Same sign: compare the magnitudes, from the exponent down.
+		MOVF	_yy+3,W
+		SUBWF	_xx+3,W
+		BTFSS	_status,C
+		GOTO	CMP32SM
+		BTFSS	_status,Z
+		GOTO	CMP32BG
+		MOVF	_yy+2,W
+		SUBWF	_xx+2,W
+		BTFSS	_status,C
+		GOTO	CMP32SM
+		BTFSS	_status,Z
+		GOTO	CMP32BG
+		MOVF	_yy+1,W
+		SUBWF	_xx+1,W
+		BTFSS	_status,C
+		GOTO	CMP32SM
+		BTFSS	_status,Z
+		GOTO	CMP32BG
+		MOVF	_yy,W
+		SUBWF	_xx,W
+		BTFSS	_status,C
+		GOTO	CMP32SM
+		BTFSC	_status,Z
+		GOTO	CMP32END
+		
+		// xx has the bigger magnitude.
+CMP32BG:
+		BTFSC	_xx+2,7
+		GOTO	CMP32LT
+		GOTO	CMP32GT
+		
+		// xx has the smaller magnitude.
+CMP32SM:
+		BTFSC	_xx+2,7
+		GOTO	CMP32GT
+		GOTO	CMP32LT
+		
+		// xx is zero; the answer depends on yy's sign.
+CMP32XZ:
+		MOVF	_yy+3,W
+		BTFSC	_status,Z
+		GOTO	CMP32END
+		BTFSC	_yy+2,7
+		GOTO	CMP32GT
+		GOTO	CMP32LT
+		
+		// yy is zero, or has the other sign; the answer depends on xx's sign.
+CMP32YZ:
+		BTFSC	_xx+2,7
+		GOTO	CMP32LT
+		
+CMP32GT:
+		MOVLW	1
+		MOVWF	_r
+		GOTO	CMP32END
+CMP32LT:
+		MOVLW	0xFF
+		MOVWF	_r
+CMP32END:
+	}
+	return r;
+}
+
 #ifdef TEST_FPMATH
 
 void main()
@@ -1190,6 +1530,20 @@ void main()
 	j = float2int(x, 1);  // j = 20
 	k = float2int(x, 0);  // k = 19
 	
+	x=muladdfloat(x,y,y);  // x = 19.9 * 10 + 10 = 209
+	j = float2int(x, 1);  // j = 209
+	
+	x=fixed2float(0x0180);  // x = 1.5
+	x=scalefloat(x, 2);  // x = 6
+	j = float2fixed(x, 1);  // j = 0x0600
+	k = float2fixed32(x, 1);  // k = 0x00060000
+	
+	x=sqrtfloat(x);  // x = 2.449...
+	x=mulfloat(x,x);  // x = 6, or very nearly
+	y=recipfloat(y);  // y = 0.1
+	k = cmpfloat(x, y);  // k = 1
+	j = cmpfloat(subfloat(0, 0), 0);  // j = 0; 0 - 0 gives -0, which equals 0
+	
 	x = 0;
 }
 
@@ -1,4 +1,20 @@
 // Header for SourceBoost-provided fpmath.c.
+// fpmathPortable.c implements the same functions in plain C, following the assembly, for use on a PC.
+//
+// Instruction cycles in the assembly, for operands of ordinary size, from simulation (min / average / max).
+// These include FPmath()'s dispatch on op, which costs about 3 cycles per op number (23 for divide),
+// but not the call, or copying the arguments in and out of FPbuff (about 25 more).
+//	int2float	41 / 80 / 122
+//	float2int	79 / 118 / 170
+//	addfloat	66 / 131 / 209
+//	subfloat	71 / 137 / 206
+//	mulfloat	424 / 490 / 562
+//	divfloat	775 / 852 / 917
+//	recipfloat	766 / 851 / 936
+//	sqrtfloat	1206 / 1326 / 1437
+//	cmpfloat	17 / 20 / 43
+//	xGTyfloat	9 / 12 / 21
+// sqrtfloat() and cmpfloat() are self-contained, and don't go through FPmath().
 
 #ifndef __FPMATH_H
 #define __FPMATH_H
@@ -14,4 +30,66 @@ single divfloat(single xx,single yy);
 single absfloat(single xx);
 char xGTyfloat(single xx, single yy);
 
+// Returns xx * yy + zz.
+// The product is rounded before the add, so this gives the same bits as mulfloat() then addfloat(),
+// but it saves copying the product out and back in.
+single muladdfloat(single xx, single yy, single zz);
+
+// Returns 1/xx.  The same as divfloat() with 1.0, without having to load it.
+single recipfloat(single xx);
+
+// Returns the square root of xx, rounded to nearest.  Negative values give 0.
+single sqrtfloat(single xx);
+
+// Returns 1 if xx > yy, -1 if xx < yy, or 0 if they're equal.
+// Unlike xGTyfloat(), anything with a zero exponent counts as zero, so 0 and -0 are equal.
+signed char cmpfloat(single xx, single yy);
+
+// Returns xx * 2^n, by changing the exponent, and saturating the way the other operations do.
+inline single scalefloat(single xx, signed char n)
+{
+	unsigned long x = (unsigned long) xx & 0xFFFFFFFF;
+	signed short e = (signed short) (x >> 24);
+	
+	if (e == 0)
+		return xx;
+	e += n;
+	if (e > 0xFF)
+		return (single) ((x & 0x800000) | 0xFF7FFFFF);
+	if (e < 1)
+		return (single) ((x & 0x800000) | 0x01000000);
+	return (single) ((x & 0x00FFFFFF) | ((unsigned long) e << 24));
+}
+
+// Conversions to and from fixed16 (8.8) and fixed32 (16.16).
+// The scaling is done on the exponent, so they give the same bits as converting to or from
+// an integer and dividing or multiplying by 256 or 65536, without the divide or multiply.
+// These take and return the underlying types, so fixed16.h and fixed32.h don't have to be included.
+
+inline single fixed2float(signed short f)
+{
+	return scalefloat(int2float(f), -8);
+}
+
+inline single fixed322float(signed long f)
+{
+	return scalefloat(int2float(f), -16);
+}
+
+// Saturates to the range of fixed16.
+inline signed short float2fixed(single xx, char round)
+{
+	long i = float2int(scalefloat(xx, 8), round);
+	if (i > 0x7FFF)
+		return 0x7FFF;
+	if (i < -0x8000)
+		return -0x8000;
+	return (signed short) i;
+}
+
+inline signed long float2fixed32(single xx, char round)
+{
+	return float2int(scalefloat(xx, 16), round);
+}
+
 #endif
\ No newline at end of file
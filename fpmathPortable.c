@@ -0,0 +1,506 @@
+/* fpmathPortable.c
+    Copyright (c) 2026 by Timothy J. Weber, tw@timothyweber.org.
+
+	The functions from fpmath.h in plain C, following the assembly in fpmath.c step by step,
+	so the same math can run on a PC (for analyzing logged data, or trying out other algorithms).
+	Link this instead of fpmath.c; it's much slower on a PIC.
+	It's meant to give the same bits as the assembly, but it hasn't yet been checked against
+	results recorded from a PIC or the simulator; no recording comes with it.  Until one has,
+	treat it as a close model, especially for the quirks below.
+
+	The format, as the assembly keeps it:
+	- bits 31-24: exponent, biased by 127 (0x7F is 2^0).  An exponent of 0 means zero.
+	- bit 23: sign.
+	- bits 22-0: mantissa, with the leading 1 implied.
+	On a PC, where long is 64 bits, a single is kept in the low 32 bits.
+
+	Some of the assembly's quirks that this keeps:
+	- Results are rounded up only when the mantissa is odd and the next bit is set.
+		Otherwise they're truncated.  float2int() does round halves away from zero.
+	- Overflow saturates to the largest magnitude (exponent 0xFF, mantissa all 1s),
+		and underflow to the smallest (exponent 1, mantissa 0), with the result's sign.
+		float2int() saturates to 0x7FFFFFFF or 0x80000000.
+	- A product or quotient can come out with an exponent of 0 (i.e. zero), or with an
+		exponent that wrapped around to 0xFF, right at the bottom of the range.
+	- Dividing by zero saturates with the sign the previous operation left in FPbuff[14],
+		not the sign of the dividend.  So the calls have to be replayed in the same order
+		to get the same results.
+
+	Define TEST_FPMATH_PORTABLE to build a main() for a PC that checks these against
+	results recorded from the assembly, once there are some.  See the bottom of the file.
+*/
+
+#ifdef _BOOSTC
+#include <system.h>
+#endif
+
+#include "fpmath.h"
+
+#define FP_MASK32  0xFFFFFFFF
+
+// The byte the assembly keeps the result's sign in (FPbuff[14]), including what it leaves
+// behind there for the next call.
+static unsigned char fpSign;
+
+static unsigned long fpBits(single x)
+{
+	return (unsigned long) x & FP_MASK32;
+}
+
+// Returns the mantissa of x, with the implied 1 put back.
+static unsigned long fpMant(unsigned long x)
+{
+	return (x & 0x7FFFFF) | 0x800000;
+}
+
+// Packs a 24-bit mantissa with the sign from fpSign.
+static single fpPack(unsigned char e, unsigned long mant)
+{
+	return (single) (((unsigned long) e << 24) | (mant & 0x7FFFFF) | ((unsigned long) (fpSign & 0x80) << 16));
+}
+
+// SETFOV32: saturates to the largest magnitude.  Shifts the carry into fpSign as it goes.
+static single fpOverflow(unsigned char carry)
+{
+	unsigned char s = fpSign & 0x80;
+	fpSign = (fpSign << 1) | carry;
+	return (single) (0xFF7FFFFF | ((unsigned long) s << 16));
+}
+
+// SETFUN32: saturates to the smallest magnitude.  The carry is always clear here.
+static single fpUnderflow()
+{
+	unsigned char s = fpSign & 0x80;
+	fpSign <<= 1;
+	return (single) (0x01000000 | ((unsigned long) s << 16));
+}
+
+// Rounds a 24-bit mantissa, given the next bit below it, and packs it.
+static single fpPackRounded(unsigned long mant, unsigned char roundBit, unsigned char e)
+{
+	if ((mant & 1) && roundBit) {
+		mant++;
+		if (mant & 0x1000000) {
+			mant >>= 1;
+			if (++e == 0)
+				return fpOverflow(0);
+		}
+	}
+	return fpPack(e, mant);
+}
+
+// Normalizes a 32-bit magnitude m, scaled by 2^(e - 0x9E), and packs it,
+// rounding it to 24 bits if round is set (NRM4032) or truncating it (NRM32).
+static single fpNormalize(unsigned long m, unsigned char e, char round)
+{
+	unsigned char shift = 0;
+
+	if (m == 0)
+		return 0;
+
+	// Whole bytes first, and the exponent all at once.
+	while (!(m & 0xFF000000)) {
+		m = (m << 8) & FP_MASK32;
+		shift += 8;
+	}
+	if (e < shift)
+		return fpUnderflow();
+	e -= shift;
+
+	while (!(m & 0x80000000)) {
+		m = (m << 1) & FP_MASK32;
+		if (--e == 0)
+			return fpUnderflow();
+	}
+
+	if (round)
+		return fpPackRounded(m >> 8, (m >> 7) & 1, e);
+	return fpPack(e, m >> 8);
+}
+
+// SETIOV32: saturates an integer result.
+static long fpIntOverflow()
+{
+	unsigned char s = fpSign & 0x80;
+	fpSign = (fpSign << 1) | 1;
+	if (s)
+		return -0x7FFFFFFF - 1;
+	return 0x7FFFFFFF;
+}
+
+single int2float(long ii)
+{
+	unsigned long m = (unsigned long) ii & FP_MASK32;
+
+	fpSign = 0;
+	if (m & 0x80000000) {
+		m = (~m + 1) & FP_MASK32;
+		fpSign = 0x80;
+	}
+	return fpNormalize(m, 0x9E, 1);
+}
+
+long float2int(single xx, char round)
+{
+	unsigned long x = fpBits(xx);
+	unsigned char e = x >> 24;
+	unsigned char shift;
+	unsigned char bytes = 0;
+	unsigned char roundBit = 0;
+	unsigned long m;
+
+	if (e == 0)
+		return 0;
+	fpSign = (x & 0x800000) ? 0xFF : 0;
+
+	// Only -2^31 fits with the largest exponent.
+	if (e >= 0x9E && (e != 0x9E || !fpSign || (x & 0x7FFFFF)))
+		return fpIntOverflow();
+
+	m = fpMant(x) << 8;
+	shift = 0x9E - e;
+
+	// Whole bytes first, at most four, rotating the top bit of each byte dropped into fpSign.
+	fpSign <<= 1;
+	while (shift >= 8) {
+		roundBit = (m >> 7) & 1;
+		m >>= 8;
+		shift -= 8;
+		if (++bytes == 4)
+			break;
+		fpSign = (fpSign << 1) | roundBit;
+	}
+	if (shift) {
+		if (bytes == 4)
+			roundBit = 0;
+		else {
+			roundBit = (m >> (shift - 1)) & 1;
+			m >>= shift;
+		}
+	}
+
+	if (round && roundBit) {
+		m++;
+		if (m & 0x80000000)
+			return fpIntOverflow();
+	}
+
+	if (fpSign & 0x80)
+		return (long) (0 - m);
+	return (long) m;
+}
+
+// FPA32.  y has already been negated, for subtraction.
+static single fpAdd(unsigned long x, unsigned long y)
+{
+	unsigned long t;
+	unsigned char signsDiffer = (x ^ y) & 0x800000 ? 1 : 0;
+	unsigned char ea, shift;
+	unsigned long a, b, s;
+
+	// Use the larger exponent; with a tie, the second argument.
+	if ((y >> 24) >= (x >> 24)) {
+		t = x;
+		x = y;
+		y = t;
+	}
+	if ((y >> 24) == 0)
+		return (single) x;
+
+	fpSign = (unsigned char) (x >> 16);
+	ea = x >> 24;
+	shift = ea - (unsigned char) (y >> 24);
+	if (shift >= 24)
+		return (single) x;
+
+	// Line up the mantissas in the top of 32 bits; what falls off the bottom is lost.
+	a = fpMant(x) << 8;
+	b = (fpMant(y) << 8) >> shift;
+
+	if (!signsDiffer) {
+		s = (a + b) & FP_MASK32;
+		if (s < a) {
+			// Carried out of the top.
+			unsigned char carry = s & 1;
+			s = (s >> 1) | 0x80000000;
+			if (++ea == 0)
+				return fpOverflow(carry);
+		}
+		return fpPackRounded(s >> 8, (s >> 7) & 1, ea);
+	}
+
+	if (a >= b)
+		return fpNormalize(a - b, ea, 1);
+
+	// Only possible with equal exponents, so there's nothing in the low byte to round.
+	fpSign ^= 0x80;
+	return fpNormalize(b - a, ea, 0);
+}
+
+single addfloat(single xx, single yy)
+{
+	return fpAdd(fpBits(xx), fpBits(yy));
+}
+
+single subfloat(single xx, single yy)
+{
+	return fpAdd(fpBits(xx), fpBits(yy) ^ 0x800000);
+}
+
+single mulfloat(single xx, single yy)
+{
+	unsigned long x = fpBits(xx);
+	unsigned long y = fpBits(yy);
+	unsigned char ea = x >> 24;
+	unsigned char eb = y >> 24;
+	unsigned short sum;
+	unsigned char e;
+	unsigned long a, b, a0, b0, hi;
+
+	if (ea == 0 || eb == 0)
+		return 0;
+
+	fpSign = (unsigned char) ((x ^ y) >> 16);
+	sum = (unsigned short) ea + eb;
+	if (sum < 0x7E)
+		return fpUnderflow();
+	if (sum - 0x7E > 0xFF)
+		return fpOverflow(1);
+	e = sum - 0x7E;
+
+	// The top 32 bits of the 48-bit product, from 8- and 16-bit pieces.
+	a = fpMant(x);
+	b = fpMant(y);
+	a0 = a & 0xFFFF;
+	b0 = b & 0xFFFF;
+	hi = (((a >> 16) * (b >> 16)) << 16) + (a >> 16) * b0 + a0 * (b >> 16) + ((a0 * b0) >> 16);
+	hi &= FP_MASK32;
+
+	if (!(hi & 0x80000000)) {
+		hi = (hi << 1) & FP_MASK32;
+		e--;
+	}
+	return fpPackRounded(hi >> 8, (hi >> 7) & 1, e);
+}
+
+single divfloat(single xx, single yy)
+{
+	unsigned long x = fpBits(xx);
+	unsigned long y = fpBits(yy);
+	unsigned char ea = x >> 24;
+	unsigned char eb = y >> 24;
+	unsigned long a, b, q, r;
+	unsigned char big;
+	unsigned char i;
+	signed short e;
+
+	if (eb == 0)
+		return fpOverflow(1);
+	if (ea == 0)
+		return 0;
+
+	fpSign = (unsigned char) ((x ^ y) >> 16);
+	a = fpMant(x);
+	b = fpMant(y);
+	big = (a >= b);
+	e = (signed short) ea - eb + 0x7E + big;
+	if (e < 0)
+		return fpUnderflow();
+	if (e > 0xFF)
+		return fpOverflow(1);
+
+	// Long division, one bit past the 24 the mantissa needs.
+	q = big;
+	r = big ? a - b : a;
+	for (i = 0; i < 25; i++) {
+		r <<= 1;
+		q <<= 1;
+		if (r >= b) {
+			r -= b;
+			q |= 1;
+		}
+	}
+	if (big)
+		q >>= 1;
+	return fpPackRounded(q >> 1, q & 1, e);
+}
+
+single muladdfloat(single xx, single yy, single zz)
+{
+	return addfloat(mulfloat(xx, yy), zz);
+}
+
+single absfloat(single xx)
+{
+	return (single) (fpBits(xx) & 0xFF7FFFFF);
+}
+
+// Returns 0xFF if xx > yy, 0 otherwise.
+char xGTyfloat(single xx, single yy)
+{
+	unsigned long x = fpBits(xx);
+	unsigned long y = fpBits(yy);
+
+	if ((x ^ y) & 0x800000)
+		return (x & 0x800000) ? 0 : 0xFF;
+	if (x & 0x800000)
+		return (y > x) ? 0xFF : 0;
+	return (x > y) ? 0xFF : 0;
+}
+
+single recipfloat(single xx)
+{
+	return divfloat(0x7F000000, xx);
+}
+
+single sqrtfloat(single xx)
+{
+	unsigned long x = fpBits(xx);
+	unsigned char e = x >> 24;
+	unsigned long m, rem = 0, root = 0, trial;
+	unsigned char bits, i;
+
+	if (e == 0 || (x & 0x800000))
+		return 0;
+
+	// Square root of the mantissa, one bit at a time, bringing the radicand in from the top
+	// of m, two bits per step.  With an odd exponent, it starts with a single bit.
+	m = fpMant(x) << 8;
+	bits = (e & 1) ? 1 : 2;
+	for (i = 0; i < 25; i++) {
+		rem = (rem << bits) | (m >> (32 - bits));
+		m = (m << bits) & FP_MASK32;
+		bits = 2;
+
+		trial = (root << 2) | 1;
+		root <<= 1;
+		if (rem >= trial) {
+			rem -= trial;
+			root |= 1;
+		}
+	}
+
+	// The root has 25 bits; the last one rounds the other 24, to nearest.
+	e = ((unsigned short) e + 0x7F) >> 1;
+	root = (root >> 1) + (root & 1);
+	if (root & 0x1000000) {
+		root >>= 1;
+		e++;
+	}
+	return (single) (((unsigned long) e << 24) | (root & 0x7FFFFF));
+}
+
+// Returns 1 if xx > yy, -1 if xx < yy, or 0 if they're equal.
+// Unlike xGTyfloat(), anything with a zero exponent counts as zero.
+signed char cmpfloat(single xx, single yy)
+{
+	unsigned long x = fpBits(xx);
+	unsigned long y = fpBits(yy);
+
+	if (!(x & 0xFF000000))
+		x = 0;
+	if (!(y & 0xFF000000))
+		y = 0;
+	if (x == y)
+		return 0;
+	if ((x ^ y) & 0x800000)
+		return (x & 0x800000) ? -1 : 1;
+
+	// Same sign: compare the magnitudes, exponent first.
+	if (x & 0x800000)
+		return (x > y) ? -1 : 1;
+	return (x > y) ? 1 : -1;
+}
+
+#ifdef TEST_FPMATH_PORTABLE
+/*	Differential test against the assembly, for a PC.
+
+	Reads one call per line from stdin, in hex:  op xx yy result
+	where op is numbered the way FPmath() numbers them, plus a couple:
+		0 int2float(xx)		1 float2int(xx, 1)	2 float2int(xx, 0)
+		3 addfloat		4 subfloat		5 mulfloat		6 divfloat
+		7 absfloat(xx)		8 xGTyfloat		9 scalefloat(xx, (signed char) yy)
+		10 recipfloat(xx)	11 sqrtfloat(xx)	12 cmpfloat
+	yy is ignored by the one-argument functions, but must be there.
+	The calls are made in order, since dividing by zero depends on the call before.
+
+	Run with "-g count seed" to write that many random calls, without results,
+	for recording on the PIC or in the simulator.  The operands lean toward the edges
+	of the range, where the assembly's quirks are.
+	With no recorded calls to check, it says so and fails, rather than passing on nothing.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+
+static unsigned long testCall(unsigned int op, unsigned long x, unsigned long y)
+{
+	switch (op) {
+		case 0:  return int2float(x) & FP_MASK32;
+		case 1:  return float2int(x, 1) & FP_MASK32;
+		case 2:  return float2int(x, 0) & FP_MASK32;
+		case 3:  return addfloat(x, y) & FP_MASK32;
+		case 4:  return subfloat(x, y) & FP_MASK32;
+		case 5:  return mulfloat(x, y) & FP_MASK32;
+		case 6:  return divfloat(x, y) & FP_MASK32;
+		case 7:  return absfloat(x) & FP_MASK32;
+		case 8:  return (unsigned char) xGTyfloat(x, y);
+		case 9:  return scalefloat(x, (signed char) y) & FP_MASK32;
+		case 10:  return recipfloat(x) & FP_MASK32;
+		case 11:  return sqrtfloat(x) & FP_MASK32;
+		default:  return (unsigned char) cmpfloat(x, y);
+	}
+}
+
+static unsigned long testRandom()
+{
+	unsigned long x = ((unsigned long) (rand() & 0xFFFF) << 16) | (rand() & 0xFFFF);
+
+	switch (rand() & 7) {
+		case 0:  return x & 0x00FFFFFF;  // zero exponent
+		case 1:  return x | 0xFE000000;  // near overflow
+		case 2:  return (x & 0x00FFFFFF) | 0x01000000;  // near underflow
+		case 3:  return x & 0xFF800000;  // powers of two
+		case 4:  return x | 0x007FFFFF;  // all ones
+		case 5:  return (x & 0x00FFFFFF) | (unsigned long) (0x70 + (rand() & 0x1F)) << 24;  // ordinary
+		default:  return x;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	unsigned int op;
+	unsigned long x, y, expected, result;
+	unsigned long count = 0, failures = 0;
+
+	if (argc == 4 && argv[1][0] == '-' && argv[1][1] == 'g') {
+		unsigned long n = strtoul(argv[2], 0, 0);
+		srand((unsigned int) strtoul(argv[3], 0, 0));
+		while (n--) {
+			op = rand() % 13;
+			x = testRandom();
+			if (op == 0 && (rand() & 1))
+				x = (unsigned long) (signed long) (rand() - RAND_MAX / 2) & FP_MASK32;  // small integers
+			printf("%u %08lx %08lx\n", op, x, testRandom());
+		}
+		return 0;
+	}
+
+	while (scanf("%u %lx %lx %lx", &op, &x, &y, &expected) == 4) {
+		result = testCall(op, x, y);
+		if (result != (expected & FP_MASK32)) {
+			if (failures < 20)
+				printf("line %lu: op %u %08lx %08lx gave %08lx, expected %08lx\n",
+					count + 1, op, x, y, result, expected);
+			failures++;
+		}
+		count++;
+	}
+	if (count == 0) {
+		printf("no recorded calls to check\n");
+		return 1;
+	}
+	printf("%lu calls, %lu mismatches\n", count, failures);
+	return failures ? 1 : 0;
+}
+
+#endif
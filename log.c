@@ -3,6 +3,12 @@
 
     Provides various ways to compute logarithms.
     
+    The 16.16 functions interpolate in tables of how far log2(1 + x) and 2^x - 1 bow away
+    from the straight line between 0 and 1, at steps of 1/32, in Q19.  Each entry i is
+		0x80000 * (log2(1 + i/32) - i/32)  or  0x80000 * (i/32 - (2^(i/32) - 1))
+    rounded to the nearest integer.  The curves are gentle enough for a quadratic through
+    three entries to be good to a few millionths.
+    
     Portions based on an algorithm described by Scott Dattalo at:
 		http://www.dattalo.com/technical/theory/logs.html
     which in turn references, and is a refinement of:
@@ -11,6 +17,7 @@
 
 #include <system.h>
 #include "fixed16.h"
+#include "fixed32.h"
 
 #include "log.h"
 
@@ -70,6 +77,125 @@ fixed16 log2_f(fixed16 x)
 		return log2_us(x) - FIXED_FROM_BYTE(8);
 }
 
+// Choose the interpolation for the 16.16 functions by defining one of these macros:
+// LOG_INTERP_QUADRATIC (default) - within about 1 LSB.
+// LOG_INTERP_LINEAR - faster, but log2 is within only about 12 LSB, and exp2 1 part in 16000.
+#if !defined(LOG_INTERP_QUADRATIC) && !defined(LOG_INTERP_LINEAR)
+#define LOG_INTERP_QUADRATIC
+#endif
+
+rom unsigned char* log2DevLo = {
+	0x00, 0xEB, 0x20, 0xC6, 0x02, 0xF6, 0xC1, 0x81, 0x4F, 0x44, 0x77, 0xFD, 0xEA, 0x51, 0x41, 0xCC,
+	0x01, 0xED, 0x9E, 0x21, 0x80, 0xC8, 0x02, 0x3A, 0x76, 0xC2, 0x25, 0xA7, 0x50, 0x26, 0x32, 0x78,
+	0x00
+};
+rom unsigned char* log2DevHi = {
+	0x00, 0x1A, 0x33, 0x48, 0x5C, 0x6C, 0x7B, 0x88, 0x93, 0x9C, 0xA3, 0xA8, 0xAC, 0xAF, 0xB0, 0xAF,
+	0xAE, 0xAA, 0xA6, 0xA1, 0x9A, 0x92, 0x8A, 0x80, 0x75, 0x69, 0x5D, 0x4F, 0x41, 0x32, 0x22, 0x11,
+	0x00
+};
+rom unsigned char* exp2DevLo = {
+	0x00, 0x28, 0x54, 0x7F, 0xA4, 0xBC, 0xC3, 0xB1, 0x81, 0x2C, 0xAD, 0xFC, 0x13, 0xEA, 0x7C, 0xC1,
+	0xB1, 0x45, 0x76, 0x3B, 0x8D, 0x64, 0xB7, 0x7E, 0xB0, 0x45, 0x32, 0x70, 0xF4, 0xB4, 0xA8, 0xC5,
+	0x00
+};
+rom unsigned char* exp2DevHi = {
+	0x00, 0x13, 0x25, 0x36, 0x46, 0x55, 0x63, 0x70, 0x7C, 0x87, 0x90, 0x98, 0xA0, 0xA5, 0xAA, 0xAD,
+	0xAF, 0xB0, 0xAF, 0xAD, 0xA9, 0xA4, 0x9D, 0x95, 0x8B, 0x80, 0x73, 0x64, 0x53, 0x41, 0x2D, 0x17,
+	0x00
+};
+
+// Returns entry i of one of the tables above.
+inline signed long DevEntry(char isExp, unsigned char i)
+{
+	unsigned short entry;
+	if (isExp)
+		MAKESHORT(entry, exp2DevLo[i], exp2DevHi[i]);
+	else
+		MAKESHORT(entry, log2DevLo[i], log2DevHi[i]);
+	return entry;
+}
+
+// Interpolates in one of the tables above, at x in Q20 (up to and including 1), and returns the result in Q34.
+signed long interpolateDev(char isExp, unsigned long x)
+{
+	unsigned char j = x >> 15;
+	unsigned long u = x & 0x7FFF;  // how far past entry j, in Q15
+	
+	if (j == 32)
+		return 0;
+		
+#ifdef LOG_INTERP_LINEAR
+	signed long y0 = DevEntry(isExp, j);
+	return (y0 << 15) + (DevEntry(isExp, j + 1) - y0) * u;
+#else
+	// Use three entries from j on, but don't run off the end.
+	if (j > 30) {
+		u += (unsigned long) (j - 30) << 15;
+		j = 30;
+	}
+	signed long y0 = DevEntry(isExp, j);
+	signed long y1 = DevEntry(isExp, j + 1);
+	signed long y2 = DevEntry(isExp, j + 2);
+	
+	// Newton's forward differences: y0 + u d1 + u (u - 1) / 2 d2.
+	signed long w = ((signed long) u * ((signed long) u - 0x8000)) >> 16;  // u (u - 1) / 2, in Q15
+	return (y0 << 15) + (y1 - y0) * (signed long) u + (y2 - 2 * y1 + y0) * w;
+#endif
+}
+
+fixed32 log2_ul(unsigned long x)
+{
+	if (x == 0)
+		return 0;
+	
+	// Normalize, bytes first.
+	unsigned char n = 31;
+	while (!(x & 0xFF000000)) {
+		x <<= 8;
+		n -= 8;
+	}
+	while (!(x & 0x80000000)) {
+		x <<= 1;
+		n--;
+	}
+	
+	// Now log2(x) = n + log2(1 + f), with f in Q31, and log2(1 + f) = f + the bow.
+	unsigned long f = x & 0x7FFFFFFF;
+	signed long bow = interpolateDev(0, (f + 0x400) >> 11);
+	f += (bow + 4) >> 3;
+	return ((fixed32) n << 16) + ((f + 0x4000) >> 15);
+}
+
+fixed32 log2_f32(fixed32 x)
+{
+	if (x < 1)
+		// Same as log2_f().
+		return 0;
+	else
+		return log2_ul(x) - FIXED32_FROM_SHORT(16);
+}
+
+fixed32 exp2_f32(fixed32 x)
+{
+	signed short n = x >> 16;  // rounds down, so the fraction is positive
+	unsigned short f = x & 0xFFFF;
+	
+	if (n >= 15)
+		return FIXED32_MAX;
+	if (n < -17)
+		return 0;
+	
+	// 2^f = 1 + f - the bow, in Q30.
+	unsigned long m = 0x40000000 + ((unsigned long) f << 14) - ((interpolateDev(1, (unsigned long) f << 4) + 8) >> 4);
+	
+	// Then scale by 2^n, rounding, to 16.16.
+	unsigned char shift = 14 - n;
+	if (shift == 0)
+		return (fixed32) m;
+	return (fixed32) ((m + ((unsigned long) 1 << (shift - 1))) >> shift);
+}
+
 #ifdef TEST_LOG
 void main(void)
 {
@@ -117,6 +243,34 @@ void main(void)
 	x = FIXED_FROM_BYTE(-1);
 	L = log2_f(x);
 	
+	// The 16.16 versions.  Time these with the simulator's stopwatch, from one breakpoint to the next.
+	fixed32 y, M;
+	
+	// log2(3.2) = 1.678072 = 0x0001AD97; this gives 0x0001AD96
+	y = MAKE_FIXED32_CONST(3, 0x3333);
+	M = log2_f32(y);
+	
+	// 2^1.678072 = 3.2 = 0x00033333, give or take an LSB
+	y = exp2_f32(M);
+	
+	// log2(1000000) = 19.931569 = 0x0013EE7B
+	M = log2_ul(1000000);
+	
+	// ln(10) = 2.302585 = 0x00024D76
+	M = ln_f32(FIXED32_FROM_SHORT(10));
+	
+	// log10(0.5) = -0.301030 = 0xFFFFB2F0
+	M = log10_f32(MAKE_FIXED32_CONST(0, 0x8000));
+	
+	// 10 log10(2) = 3.010300 dB = 0x000302A3
+	M = dB_f32(FIXED32_FROM_SHORT(2));
+	
+	// 20 log10(2) = 6.020600 dB = 0x00060546
+	M = dBAmplitude_f32(FIXED32_FROM_SHORT(2));
+	
+	// 2^-3.5 = 0.088388 = 0x000016A1
+	y = exp2_f32(MAKE_FIXED32_CONST(-4, 0x8000));
+	
 	x = 0;
 }
 #endif
\ No newline at end of file
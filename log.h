@@ -8,6 +8,7 @@
 #define _LOG_H_
 
 #include "fixed16.h"
+#include "fixed32.h"
 
 // Returns the log base 2 of x.
 // If x is 0, returns 0.
@@ -17,5 +18,68 @@ fixed16 log2_us(unsigned short x);
 // If X is nonpositive, returns 0.
 fixed16 log2_f(fixed16 x);
 
+// The functions below work in 16.16, for when 8 fractional bits aren't enough.
+// Error bounds were measured against double-precision results over the whole input range
+// (every 16.16 input for exp2_f32, and a dense sample for the others), with the default
+// quadratic interpolation (see log.c), in units of the result's last place (LSB).
+// Cost: normalizing shifts, then three table lookups and three 32-bit multiplies;
+// the natural log, log10 and dB versions add one fixed32 multiply, and need fixed32.c.
+
+// Returns the log base 2 of x, in 16.16.
+// If x is 0, returns 0.
+// Within 1 LSB.
+fixed32 log2_ul(unsigned long x);
+
+// Returns the log base 2 of x.
+// If x is nonpositive, returns 0.
+// Within 1 LSB.
+fixed32 log2_f32(fixed32 x);
+
+// Returns 2 to the power x.
+// Saturates to FIXED32_MAX for x >= 15; small results are rounded to the nearest LSB, down to 0.
+// Within 1 LSB for results below 4 (0.6 LSB below 1).  In parts per million, that's up to 8.7 for
+// results in [1, 2) and 5.0 in [2, 4); then up to 3.2 in [4, 8), 2.3 in [8, 16), and 1.8 from 16 up.
+fixed32 exp2_f32(fixed32 x);
+
+// Constants for changing the base of log2, in 8.24, so they don't add much error of their own.
+#define LOG_LN2  0x00B17218  // ln(2) = 0.693147
+#define LOG_LOG10_2  0x004D104D  // log10(2) = 0.301030
+#define LOG_DB_2  0x0302A305  // 10 log10(2) = 3.010300
+#define LOG_DB_AMPLITUDE_2  0x06054609  // 20 log10(2) = 6.020600
+
+// Returns the 16.16 log x times c, an 8.24 constant.
+inline fixed32 logScale(fixed32 x, signed long c)
+{
+	return (fixed32MulSat(x, c) + 0x80) >> 8;
+}
+
+// Returns the natural log of x.  If x is nonpositive, returns 0.
+// Within 2 LSB.
+inline fixed32 ln_f32(fixed32 x)
+{
+	return logScale(log2_f32(x), LOG_LN2);
+}
+
+// Returns the log base 10 of x.  If x is nonpositive, returns 0.
+// Within 1 LSB.
+inline fixed32 log10_f32(fixed32 x)
+{
+	return logScale(log2_f32(x), LOG_LOG10_2);
+}
+
+// Returns x, a ratio of powers, in decibels: 10 log10(x).  If x is nonpositive, returns 0.
+// Within 4 LSB (0.00006 dB).
+inline fixed32 dB_f32(fixed32 x)
+{
+	return logScale(log2_f32(x), LOG_DB_2);
+}
+
+// Returns x, a ratio of amplitudes (e.g. voltages), in decibels: 20 log10(x).  If x is nonpositive, returns 0.
+// Within 6 LSB (0.0001 dB).
+inline fixed32 dBAmplitude_f32(fixed32 x)
+{
+	return logScale(log2_f32(x), LOG_DB_AMPLITUDE_2);
+}
+
 
 #endif //_LOG_H_
@@ -40,27 +40,264 @@ T averageUnsigned(T a, T b)
 	return result;
 }
 
-// Return the value of the lowest bit set in x, and clear it in x.
+// Streaming statistics.
+// These keep their state in variables the caller owns, and are passed pointers to it,
+// so they can be used on several channels at once, and from an ISR.
+// None of them divides; averages take their length as a power of 2, given as a shift.
+
+// Returns x / 2^shift, rounded toward zero the same way as integer division,
+// where a plain arithmetic shift would round negative values down.
+template <class T>
+inline T shiftRightSigned(T x, byte shift)
+{
+	if (x < 0)
+		return -((-x) >> shift);
+	else
+		return x >> shift;
+}
+
+// Exponential weighted moving average, over about 2^shift samples (alpha = 1 / 2^shift).
+// Same as *average += (newValue - *average) / (1 << shift), so newValue - *average must fit in T.
+template <class T>
+inline void ewmaUpdate(T* average, T newValue, byte shift)
+{
+	*average += shiftRightSigned<T>(newValue - *average, shift);
+}
+
+// Exponentially weighted mean and variance, updated the way Welford's method does it,
+// with 1 / 2^shift as the weight of each new sample instead of 1 / n.
+// The variance is in the squared units of the samples.
+// Set *mean to the first sample (or a good guess) and *variance to 0 to start.
+template <class T>
+inline void ewmVarianceUpdate(T* mean, unsigned long* variance, T newValue, byte shift)
+{
+	signed long diff = (signed long) newValue - *mean;
+	signed long increment = shiftRightSigned<signed long>(diff, shift);
+	*mean += (T) increment;
+	
+	// variance = (1 - alpha) (variance + alpha diff^2), rearranged so nothing overflows or divides.
+	// diff and diff - increment have the same sign, so their product is positive,
+	// and with diff held to 16 bits, it fits when multiplied unsigned.
+	// That only changes anything for wider samples: one further than that from the mean counts as that far.
+	if (diff > 0xFFFF)
+		diff = 0xFFFF;
+	else if (diff < -0xFFFF)
+		diff = -0xFFFF;
+	increment = shiftRightSigned<signed long>(diff, shift);
+	*variance -= *variance >> shift;
+	*variance += ((unsigned long) diff * (unsigned long) (diff - increment)) >> shift;
+}
+
+// Returns the square root of x, rounded down.
+// Bit by bit, with shifts and subtractions only - no multiplies or divides.
+inline unsigned short sqrtUnsigned(unsigned long x)
+{
+	unsigned long root = 0;
+	unsigned long place = 0x40000000;  // the highest power of 4 that fits
+	
+	while (place > x)
+		place >>= 2;
+	
+	while (place != 0) {
+		if (x >= root + place) {
+			x -= root + place;
+			root = (root >> 1) + place;
+		} else
+			root >>= 1;
+		place >>= 2;
+	}
+	
+	return (unsigned short) root;
+}
+
+// The running state of a windowed minimum or maximum.
+// The values and their times are kept by the caller, in arrays of window entries.
+typedef struct {
+	byte window;  // the number of most recent samples to look over
+	byte head;  // the index of the oldest value still in the deque, which is the extreme one
+	byte count;  // the number of values in the deque
+	byte now;  // counts samples, modulo 256
+} WindowedExtreme;
+
+inline void initWindowedExtreme(WindowedExtreme* w, byte window)
+{
+	w->window = window;
+	w->head = 0;
+	w->count = 0;
+	w->now = 0;
+}
+
+// Adds newValue, and returns the largest (if isMax) or smallest of the last w->window values.
+// The values are kept in a monotonic deque: a value that's beaten by a newer one can never
+// be the answer again, so it's dropped.  Each value is added and dropped once, so this is
+// constant time on average.
+template <class T>
+T windowedExtreme(WindowedExtreme* w, T* values, byte* times, T newValue, byte isMax)
+{
+	byte i;
+	
+	// Drop the front if it's aged out of the window.  Only one can, per new sample.
+	// Doing this first leaves room for the new one.
+	if (w->count && (byte) (w->now - times[w->head]) >= w->window) {
+		if (++w->head >= w->window)
+			w->head = 0;
+		w->count--;
+	}
+	
+	// Drop values from the back that are no better than the new one.
+	while (w->count) {
+		i = w->head + w->count - 1;
+		if (i >= w->window)
+			i -= w->window;
+		if (isMax ? values[i] > newValue : values[i] < newValue)
+			break;
+		w->count--;
+	}
+	
+	// Add the new one at the back.
+	i = w->head + w->count;
+	if (i >= w->window)
+		i -= w->window;
+	values[i] = newValue;
+	times[i] = w->now;
+	w->count++;
+	
+	w->now++;
+	return values[w->head];
+}
+
+template <class T>
+inline T windowedMax(WindowedExtreme* w, T* values, byte* times, T newValue)
+{
+	return windowedExtreme<T>(w, values, times, newValue, true);
+}
+
+template <class T>
+inline T windowedMin(WindowedExtreme* w, T* values, byte* times, T newValue)
+{
+	return windowedExtreme<T>(w, values, times, newValue, false);
+}
+
+// Returns the median of three values.
+template <class T>
+inline T median3(T a, T b, T c)
+{
+	if (a > b) {
+		T temp = a;
+		a = b;
+		b = temp;
+	}
+	// Now a <= b.
+	if (c >= b)
+		return b;
+	else
+		return max(a, c);
+}
+
+// Median filter over the last n samples, where n is odd.
+// history holds the samples in the order they arrived, and sorted holds the same ones sorted;
+// fill both with the same starting value, and start *next at 0.
+// Each new sample replaces the oldest one, and is moved into place with one pass of an insertion sort.
+// Works for any integer or fixed-point type.
+template <class T>
+T medianFilter(T* history, T* sorted, byte* next, byte n, T newValue)
+{
+	T oldest = history[*next];
+	history[*next] = newValue;
+	if (++*next >= n)
+		*next = 0;
+	
+	// Find the oldest value in sorted, and put the new one in its place.
+	byte i = 0;
+	while (sorted[i] != oldest)
+		i++;
+	
+	// Then move it up or down to where it belongs.
+	while (i + 1 < n && sorted[i + 1] < newValue) {
+		sorted[i] = sorted[i + 1];
+		i++;
+	}
+	while (i > 0 && sorted[i - 1] > newValue) {
+		sorted[i] = sorted[i - 1];
+		i--;
+	}
+	sorted[i] = newValue;
+	
+	return sorted[n >> 1];
+}
+
+// Bit scanning.
+// These take the same time whichever bits are set, instead of walking the bits one at a time.
+// On a host compiler, they use the compiler's builtins.
+
+// Returns x with only its lowest set bit left, or 0 if x is 0.
+template <class T>
+inline T isolateLowestBit(T x)
+{
+	return x & (T) (0 - x);
+}
+
+// Returns the index of the single bit set in b, which must be a power of 2.
+// Binary search by masks, so it needs no multiply or table.
+template <class T>
+inline byte powerOf2Index(T b)
+{
+#ifdef _BOOSTC
+	byte i = 0;
+	if (sizeof(T) > 2 && (b & (T) 0xFFFF0000))
+		i += 16;
+	if (sizeof(T) > 1 && (b & (T) 0xFF00FF00))
+		i += 8;
+	if (b & (T) 0xF0F0F0F0)
+		i += 4;
+	if (b & (T) 0xCCCCCCCC)
+		i += 2;
+	if (b & (T) 0xAAAAAAAA)
+		i += 1;
+	return i;
+#else
+	// __builtin_ctzl(0) is undefined; give 0, as the search above does.
+	return b ? __builtin_ctzl(b) : 0;
+#endif
+}
+
+// Returns the index of the lowest bit set in x (find first set, counting from 0).
+// Returns 0 if x is 0, so check for that first if it matters.
+template <class T>
+inline byte lowestSetBitIndex(T x)
+{
+	return powerOf2Index<T>(isolateLowestBit<T>(x));
+}
+
+// Returns the number of bits set in b.
+inline byte bitCount(byte b)
+{
+#ifdef _BOOSTC
+	// Add up pairs, then nibbles, in place.
+	b -= (b >> 1) & 0x55;
+	b = (b & 0x33) + ((b >> 2) & 0x33);
+	return (b + (b >> 4)) & 0x0F;
+#else
+	return __builtin_popcount(b);
+#endif
+}
+
+// Return the index of the lowest bit set in x, and clear it in x.
 // The highest bit that we will look at is highestBit.
 // Returns 0 if no bit at or below highestBit is set.
 template <class T>
 inline
 T clearLowestSetBit(T& x, byte highestBit)
 {
-	// Save time: check for zero first.
-	if (x == 0)
+	T lowest = isolateLowestBit<T>(x);
+	
+	// Save time: check for zero first.  Bits above highestBit are left alone,
+	// and since lowest is the lowest one, it's enough to check it.
+	if (lowest == 0 || (lowest >> highestBit) > 1)
 		return 0;
 		
-	byte i;
-	T mask = 1;
-	for (i = 0; i <= highestBit; i++) {
-		if (x & mask) {
-			x ^= mask;
-			return i;
-		}
-		mask <<= 1;
-	}
-	return 0;
+	x ^= lowest;
+	return powerOf2Index<T>(lowest);
 }
 
 #endif
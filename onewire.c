@@ -4,6 +4,7 @@
 
 #include <system.h>
 
+#include "crc_8bit.h"
 #include "onewire.h"
 #include "onewire-const.h"
 
@@ -95,6 +96,32 @@ void OW_SendByte(unsigned char b)
 	OUTPUT_HIGH;
 }
 
+void OW_SendBit(byte b)
+{
+	// Disable interrupts.
+	intcon.GIE = 0;
+
+		// Low for 4 us (docs say 5 us).
+		nop();
+		nop();
+		OUTPUT_LOW;
+		nop();
+		nop();
+		
+		// Output the bit.
+		if (b)
+			set_bit(ow_port, OW_PIN);
+			
+		// Wait for 60 us.
+		delay_10us(6);
+		
+		// Recovery time >= 1 us.
+		OUTPUT_HIGH;
+	
+	// Restore interrupts.
+	intcon.GIE = 1;
+}
+
 byte OW_ReadBit()
 {
 	byte result = 0;
@@ -336,6 +363,32 @@ void OW_SendByte_2(unsigned char b)
 	OUTPUT_HIGH_2;
 }
 
+void OW_SendBit_2(byte b)
+{
+	// Disable interrupts.
+	intcon.GIE = 0;
+
+		// Low for 4 us (docs say 5 us).
+		nop();
+		nop();
+		OUTPUT_LOW_2;
+		nop();
+		nop();
+		
+		// Output the bit.
+		if (b)
+			set_bit(ow_port, OW_PIN_2);
+			
+		// Wait for 60 us.
+		delay_10us(6);
+		
+		// Recovery time >= 1 us.
+		OUTPUT_HIGH_2;
+	
+	// Restore interrupts.
+	intcon.GIE = 1;
+}
+
 byte OW_ReadBit_2()
 {
 	byte result = 0;
@@ -529,6 +582,14 @@ byte OWB_ReadBit(byte bus)
 		return OW_ReadBit();
 }
 
+void OWB_SendBit(byte bus, byte b)
+{
+	if (bus)
+		OW_SendBit_2(b);
+	else
+		OW_SendBit(b);
+}
+
 void OWB_PowerOn(byte bus)
 {
 	if (bus)
@@ -536,3 +597,120 @@ void OWB_PowerOn(byte bus)
 	else
 		OW_PowerOn();
 }
+
+//=============================================================================
+// ROM search and addressing.
+// The search follows Maxim's application note 187, "1-Wire Search Algorithm."
+
+// Sets up the search to find the first device, of search->family if that's set.
+void OWB_SearchStart(OWSearch* search)
+{
+	byte i;
+	
+	search->lastDevice = false;
+	
+	if (search->family) {
+		// Start from the lowest possible ROM code in the family.
+		// Conflicts below bit 64 follow it; the one at 64, if any, takes the 1 branch.
+		search->rom[0] = search->family;
+		for (i = 1; i < OW_ROM_LEN; i++)
+			search->rom[i] = 0;
+		search->lastDiscrepancy = 64;
+	} else
+		search->lastDiscrepancy = 0;
+}
+
+byte OWB_SearchFirst(byte bus, OWSearch* search, byte family)
+{
+	search->family = family;
+	OWB_SearchStart(search);
+	
+	return OWB_SearchNext(bus, search);
+}
+
+byte OWB_SearchNext(byte bus, OWSearch* search)
+{
+	byte bitNumber;  // 1-64, least significant bit of rom[0] first
+	byte lastZero = 0;
+	byte romByte = 0;
+	byte romMask = 1;
+	byte idBit, complementBit, direction;
+	Crc8Context ctx;
+	
+	if (!search->lastDevice && OWB_Reset(bus)) {
+		OWB_SendByte(bus, OW_SearchROM);
+		
+		for (bitNumber = 1; bitNumber <= 64; bitNumber++) {
+			// Every device that's still in the search sends its next bit, then the complement,
+			// and the bus reads the AND of them.
+			idBit = OWB_ReadBit(bus) != 0;
+			complementBit = OWB_ReadBit(bus) != 0;
+			
+			if (idBit && complementBit)
+				// Nobody answered.
+				break;
+				
+			if (idBit != complementBit)
+				// They all agree.
+				direction = idBit;
+			else {
+				// A conflict: some have a 0 here, and some a 1.
+				// Below the last discrepancy, go the same way as last time; at it, take the 1 branch this time;
+				// past it, take the 0 branch first.
+				if (bitNumber < search->lastDiscrepancy)
+					direction = (search->rom[romByte] & romMask) != 0;
+				else
+					direction = bitNumber == search->lastDiscrepancy;
+				
+				if (!direction)
+					lastZero = bitNumber;
+			}
+			
+			if (direction)
+				search->rom[romByte] |= romMask;
+			else
+				search->rom[romByte] &= ~romMask;
+				
+			// Devices with the other bit drop out.
+			OWB_SendBit(bus, direction);
+			
+			romMask <<= 1;
+			if (romMask == 0) {
+				romByte++;
+				romMask = 1;
+			}
+		}
+		
+		// Including the CRC byte itself, the result is 0 if the ROM code is good.
+		crc8InitContext(&ctx);
+		if (bitNumber > 64 && crc8Block(&ctx, search->rom, OW_ROM_LEN) == 0 && search->rom[0] != 0) {
+			search->lastDiscrepancy = lastZero;
+			search->lastDevice = lastZero == 0;
+			
+			// The devices are found in order, so once past the family, there aren't any more of it.
+			if (search->family == 0 || search->rom[0] == search->family)
+				return true;
+		}
+	}
+	
+	// Done, failed, or past the family: start over next time.
+	OWB_SearchStart(search);
+	return false;
+}
+
+void OWB_MatchROM(byte bus, byte* rom)
+{
+	byte i;
+	
+	OWB_SendByte(bus, OW_MatchROM);
+	for (i = 0; i < OW_ROM_LEN; i++)
+		OWB_SendByte(bus, rom[i]);
+}
+
+void OWB_Select(byte bus, byte* rom)
+{
+	if (rom)
+		OWB_MatchROM(bus, rom);
+	else
+		OWB_SendByte(bus, OW_SkipROM);
+}
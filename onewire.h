@@ -13,6 +13,9 @@
 	
 	To maintain timing requirements, interrupts are disabled during bus reads and writes,
 	so this module can't coexist with something that requires real-time interrupts.
+	
+	Any number of devices can share a bus: find their ROM codes with OWB_SearchFirst() and
+	OWB_SearchNext(), then address each one with OWB_MatchROM().  The search needs crc_8bit.c.
 */
 
 #include "types-tjw.h"
@@ -43,6 +46,10 @@ byte OW_ReadByte_2();
 byte OW_ReadBit();
 byte OW_ReadBit_2();
 
+// Sends a single bit to the bus: a one if b is nonzero.
+void OW_SendBit(byte b);
+void OW_SendBit_2(byte b);
+
 // Drives power to the bus until the next operation.
 void OW_PowerOn();
 void OW_PowerOn_2();
@@ -53,4 +60,37 @@ char OWB_Reset(byte bus);
 void OWB_SendByte(byte bus, unsigned char b);
 byte OWB_ReadByte(byte bus);
 byte OWB_ReadBit(byte bus);
+void OWB_SendBit(byte bus, byte b);
 void OWB_PowerOn(byte bus);
+
+// Addressing devices by ROM code.
+
+// Each device has a unique 64-bit ROM code: the family code (which kind of device it is),
+// then a 48-bit serial number, then a CRC-8 of the first 7 bytes.
+#define OW_ROM_LEN  8
+
+// The state of a search of a bus, between calls.
+typedef struct {
+	byte rom[OW_ROM_LEN];  // the ROM code of the last device found
+	byte lastDiscrepancy;  // the bit (1-64) where the last search last took the 0 branch of a conflict; 0 if none
+	byte lastDevice;  // true if the last search found the last device
+	byte family;  // the family code to look for, or 0 for all devices
+} OWSearch;
+
+// Starts a search of the bus, for devices with the given family code, or for all devices if family is 0.
+// Returns true and puts the first device's ROM code in search->rom if there is one.
+// Each device takes about 13 ms to find, at the standard speed.
+byte OWB_SearchFirst(byte bus, OWSearch* search, byte family);
+
+// Finds the next device, after OWB_SearchFirst() or a previous call.
+// Returns false when there are no more (of the family, if there is one), or if the search was
+// interrupted by a bad CRC or an empty bus; then it starts over at the first device next time.
+byte OWB_SearchNext(byte bus, OWSearch* search);
+
+// Call after OWB_Reset() to address the device with the given ROM code.
+// The next command goes to it alone.
+void OWB_MatchROM(byte bus, byte* rom);
+
+// Call after OWB_Reset() to address the device with the given ROM code,
+// or all of the devices on the bus (with OW_SkipROM) if rom is 0.
+void OWB_Select(byte bus, byte* rom);
@@ -2,3 +2,17 @@
 
 // The number of bytes to reserve for the input queue.
 #define SERIAL_QUEUE_LENGTH  17
+
+// The character that ends a line, for ReadSerialLine().
+// Optional; defaults to '\n'.
+// #define SERIAL_LINE_END  '\r'
+
+// Settings for SOFTWARE_RECEIVE.  All optional; the defaults are shown.
+// The receive pin must be one of RB4..RB7, for interrupt-on-change.
+// #define SOFT_RX_PIN  7
+// #define SOFT_RX_BAUD_RATE  9600
+// The oscillator frequency, in Hz.
+// #define SOFT_RX_CLOCK_FREQ  4000000
+// Instruction cycles from an interrupt to the point where SerialInterrupt() samples the pin;
+// depends on your ISR's context saving and what it checks before calling SerialInterrupt().
+// #define SOFT_RX_LATENCY  20
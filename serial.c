@@ -1,55 +1,171 @@
 /* serial.c
     Copyright (c) 2006, 2007 by Timothy J. Weber, tw@timothyweber.org.
 
-	Routines for software serial support.
-	Supports 9600 baud, 8/N/1, receive-only, on pin RB7.
-	(Could be parameterized, but on the 16F627/628/648 must be on PORTB for interrupt-on-change.)
+	Routines for serial support.
+	Receives 8/N/1 using the hardware USART (9600 baud), or with SOFTWARE_RECEIVE,
+	in software on any of RB4..RB7, at the baud rate and clock given in serial-consts.h.
+	(On the 16F627/628/648 the software pin must be on PORTB for interrupt-on-change.)
+	
+	The software receiver can be checked on a PC, bit by bit, with SerialSim.c.
 */
 
 #define IN_SERIAL
 
+#ifdef SERIAL_SIM
+#include "SerialSim.h"
+#else
 #include <system.h>
+#endif
 
 #include "serial.h"
 #include "serial-consts.h"
 
+#ifndef SERIAL_LINE_END
+	#define SERIAL_LINE_END  '\n'
+#endif
 
 #ifdef SOFTWARE_RECEIVE
 	
-	#define RECEIVE_PIN  7
-	bit receiveBit@PORTB.RECEIVE_PIN;
+	// Defaults match the original fixed settings: RB7, 9600 baud, 4 MHz.
+	// The pin has to be one of RB4..RB7, since the start bit is caught with interrupt-on-change.
+	#ifdef SOFT_RX_PORT
+		#error "The software receiver only works on PORTB; set SOFT_RX_PIN to 4-7 instead of defining SOFT_RX_PORT."
+	#endif
+	#define SOFT_RX_PORT  PORTB
+	#ifndef SOFT_RX_PIN
+		#define SOFT_RX_PIN  7
+	#endif
+	#if SOFT_RX_PIN < 4 || SOFT_RX_PIN > 7
+		#error "SOFT_RX_PIN must be 4-7, for interrupt-on-change on RB4..RB7."
+	#endif
+	#ifndef SOFT_RX_BAUD_RATE
+		#define SOFT_RX_BAUD_RATE  9600
+	#endif
+	#ifndef SOFT_RX_CLOCK_FREQ
+		#define SOFT_RX_CLOCK_FREQ  4000000
+	#endif
+	#ifndef SOFT_RX_LATENCY
+		#define SOFT_RX_LATENCY  20
+	#endif
 	
-	char bitsRemaining;  // to be read, including stop bit
+	#ifndef SERIAL_SIM
+	bit receiveBit@SOFT_RX_PORT.SOFT_RX_PIN;
+	#endif
+
+	// Bits still to be sampled, counting down:
+	// START_BIT while validating the start bit, then the 8 data bits, then 1 for the stop bit.
+	// 0 when idle, waiting for a start bit.
+	char bitsRemaining;
+	#define START_BIT  10
+
 	unsigned char dataIn;  // the byte we're in the process of reading; not yet complete.
 	
-	#define BAUD_RATE  9600
-	#define CLOCK_FREQ  4000000
-	#define CYCLE_RATE  CLOCK_FREQ / 4
+	// One bit period, in instruction cycles, rounded to the nearest cycle.
+	#define BIT_CYCLES  ((SOFT_RX_CLOCK_FREQ / 4 + SOFT_RX_BAUD_RATE / 2) / SOFT_RX_BAUD_RATE)
 	
-	// one baud period, in cycles
-	#define BAUD_PERIOD  ((unsigned char) (CYCLE_RATE / BAUD_RATE))
+	// Pick the smallest Timer2 prescaler that fits a bit period into 8 bits.
+	#if BIT_CYCLES <= 256
+		#define T2_PRESCALE  1
+		#define T2_CKPS  0b00
+	#elif BIT_CYCLES <= 1024
+		#define T2_PRESCALE  4
+		#define T2_CKPS  0b01
+	#elif BIT_CYCLES <= 4096
+		#define T2_PRESCALE  16
+		#define T2_CKPS  0b10
+	#else
+		#error "SOFT_RX_BAUD_RATE is too slow for Timer2 at this clock."
+	#endif
 	
-	// 1.5 baud periods, in cycles
-	#define INTRO_BAUD_PERIOD  ((unsigned char) (CYCLE_RATE * 3 / 2 / BAUD_RATE))
+	// One bit period, in Timer2 ticks.
+	#define BIT_TICKS  ((BIT_CYCLES + T2_PRESCALE / 2) / T2_PRESCALE)
+
+	// Rounding the bit period to whole ticks puts each sample a little further off,
+	// over the 9.5 bit periods from the start edge to the middle of the stop bit.
+	// Sampling in the middle of each bit leaves half a bit of margin.
+	// A sender whose clock is off by 3% takes 28.5% of that; keep our own share under 1% per bit,
+	// leaving the rest for interrupt latency jitter.
+	#if (BIT_TICKS * T2_PRESCALE * SOFT_RX_BAUD_RATE * 100 > SOFT_RX_CLOCK_FREQ / 4 * 101) \
+			|| (BIT_TICKS * T2_PRESCALE * SOFT_RX_BAUD_RATE * 100 < SOFT_RX_CLOCK_FREQ / 4 * 99)
+		#error "SOFT_RX_BAUD_RATE can't be timed within 1% at this clock."
+	#endif
+
+	// Timer2 periods.  PR2 is one less than the number of ticks, since the timer resets on the tick after a match.
+	#define BIT_PERIOD  ((unsigned char) (BIT_TICKS - 1))
+
+	// Timer2 ticks from starting the timer to the match for the middle of the start bit:
+	// half a bit, less the latency before the timer is started at the edge, and again after the match.
+	#define START_TICKS  ((BIT_CYCLES / 2 - 2 * SOFT_RX_LATENCY + T2_PRESCALE / 2) / T2_PRESCALE)
+	#if START_TICKS < 1
+		#error "SOFT_RX_BAUD_RATE is too fast for this clock and SOFT_RX_LATENCY: half a bit must be more than twice the latency."
+	#endif
+	
+	// Timer2 keeps the bit period throughout, and starts this far along, so it first matches after START_TICKS.
+	// Changing PR2 after that match instead would let a late interrupt find the timer already past the new period,
+	// and it would count all the way around, skipping a bit.
+	#define START_PRELOAD  ((unsigned char) (BIT_TICKS - START_TICKS))
+	
+	// The same, for a start bit that's found already begun, just now, when there's no latency to allow for.
+	#define START_NOW_PRELOAD  ((unsigned char) (BIT_TICKS - START_TICKS - SOFT_RX_LATENCY / T2_PRESCALE))
+	
+	// The stop bit is sampled early, by twice the latency but no more than a fifth of a bit, so the
+	// interrupt is over before a fast sender's next start bit, and that edge isn't caught late.
+	// A 3% slow sender's stop bit has still begun by then.
+	// PR2 is changed for it right after a match, so the timer can't have passed it yet.
+	#if 2 * SOFT_RX_LATENCY / T2_PRESCALE < BIT_TICKS / 5
+		#define STOP_EARLY  (2 * SOFT_RX_LATENCY / T2_PRESCALE)
+	#else
+		#define STOP_EARLY  (BIT_TICKS / 5)
+	#endif
+	#define STOP_PERIOD  ((unsigned char) (BIT_TICKS - STOP_EARLY - 1))
+	#if BIT_TICKS - STOP_EARLY <= 2 * SOFT_RX_LATENCY / T2_PRESCALE
+		#error "SOFT_RX_BAUD_RATE is too fast for this clock and SOFT_RX_LATENCY."
+	#endif
 
 #endif
 
 // The input queue.
-#ifdef SOFTWARE_RECEIVE
-	// Currently only one byte.
-	unsigned char dataQueue;
-#else
-	// A FIFO queue, growing forward in memory.
-	// Head is the first element added; Tail is the next one to be added.
-	// Head == Tail when empty.
-	// (Tail + 1) mod n == Head when full.
-	unsigned char dataQueue[SERIAL_QUEUE_LENGTH];
-	unsigned char* dataQueueHead;
-	unsigned char* dataQueueTail;
-	unsigned char* queueNextTail;
-	const unsigned char* queueEnd = dataQueue + SERIAL_QUEUE_LENGTH;  // one past the end
+// A FIFO queue, growing forward in memory.
+// Head is the first element added; Tail is the next one to be added.
+// Head == Tail when empty.
+// (Tail + 1) mod n == Head when full.
+unsigned char dataQueue[SERIAL_QUEUE_LENGTH];
+unsigned char* dataQueueHead;
+unsigned char* dataQueueTail;
+unsigned char* queueNextTail;
+const unsigned char* queueEnd = dataQueue + SERIAL_QUEUE_LENGTH;  // one past the end
 	
-#endif
+// Adds c at the tail of the queue.
+// The caller must already have checked that there's room.
+inline void EnqueueByte(unsigned char c)
+{
+	*dataQueueTail = c;
+
+	dataQueueTail = queueNextTail;
+
+	if (++queueNextTail == queueEnd)
+		queueNextTail = dataQueue;
+
+	if (c == SERIAL_LINE_END)
+		++ser_linesQueued;
+}
+
+// Records an error of the given type, and counts it in *counter.
+inline void RecordError(char type, unsigned char* counter)
+{
+	ser_error = 1;
+	ser_errorType = type;
+	if (*counter != 0xFF)
+		++*counter;
+}
+
+void ClearSerialErrors()
+{
+	ser_error = 0;
+	ser_framingErrors = 0;
+	ser_collisionErrors = 0;
+	ser_overflowErrors = 0;
+}
 
 void InitializeSerial()
 {
@@ -60,7 +176,7 @@ void InitializeSerial2(bool useReceive, bool useTransmit)
 {
 	// Initialize globals.
 	ser_hasData = 0;
-	ser_error = 0;
+	ClearSerialErrors();
 	
 	// Stuff for both receive and transmit.
 	
@@ -85,23 +201,28 @@ void InitializeSerial2(bool useReceive, bool useTransmit)
 	
 	if (useReceive) {
 	
+		dataQueueHead = dataQueueTail = dataQueue;
+		queueNextTail = dataQueueTail + 1;
+		ser_linesQueued = 0;
+
 	#ifdef SOFTWARE_RECEIVE
 		
 		// Initialize module-locals.
 		bitsRemaining = 0;
 		
+		// Set up Timer 2 for one bit period, with no postscaling.
+		t2con = T2_CKPS;  // ...but don't start it yet.
+		pr2 = BIT_PERIOD;
+
+		pir1.TMR2IF = 0;
+		pie1.TMR2IE = 0;
+		intcon.PEIE = 1;
+
 		// Set up RB4..7 for interrupt-on-change.
-		intcon.RBIE = 1;
+		// Reading the port ends any mismatch condition.
+		dataIn = portb;
 		intcon.RBIF = 0;
-		
-		// Set up Timer 2 for 9600 baud.
-		// Ideally, that's every 104 instructions.
-		// So we need no pre- or post-scaling for a one-byte counter.
-		t2con.TMR2ON = 0;  // ...but don't start it yet.
-		
-		intcon.TMR2IF = 0;
-		intcon.TMR2IE = 0;
-		intcon.PEIE = 1;
+		intcon.RBIE = 1;
 	
 	#else
 		
@@ -109,9 +230,6 @@ void InitializeSerial2(bool useReceive, bool useTransmit)
 		pie1.RCIE = 1;  // Enable interrupts on reception.
 		
 		intcon.PEIE = 1;
-		
-		dataQueueHead = dataQueueTail = dataQueue;
-		queueNextTail = dataQueueTail + 1;
 	
 	#endif
 	}
@@ -125,115 +243,101 @@ void SerialInterrupt()
 	#ifdef SOFTWARE_RECEIVE
 		
 		// First, try to continue a byte that's already been started.
-		if (pir1.TMR2IF) {
-			if (!ser_error && bitsRemaining) {
-				// Shift the next bit in from the left.
-				if (--bitsRemaining > 0)
-					// Rotate receivePin into dataIn.
-					asm {
-						bcf _status, C
-						btfsc _portb, RECEIVE_PIN
-						bsf _status, C
-						rrf _dataIn, F
-					}
-				else
-					// This is the stop bit.
-					if (!receiveBit) {
-						// But it wasn't set - must be a framing error.
-						ser_error = 1;
-						ser_errorType = 'F';
-					}
+		if (pir1.TMR2IF && pie1.TMR2IE) {
+			// Sample first, so the timing doesn't depend on the path taken below.
+			bit sample = receiveBit;
+			pir1.TMR2IF = 0;
 				
-				// If we're out of bits, we've received the entire byte.
-				// (Because the first 1 we'll encounter was the start bit we shifted in.)
-				if (!bitsRemaining && !ser_error) {
-					// Done, and no error.
-					// Return it.
-					if (ser_hasData) {
-						// Collision error.
-						ser_error = 1;
-						ser_errorType = 'C';
-					}
-						
-					dataQueue = dataIn;
+			if (bitsRemaining == START_BIT) {
+				// Middle of the start bit.
+				if (sample)
+					// The line went back high - just a glitch.  Wait for another edge.
+					bitsRemaining = 0;
+				else {
+					// Valid start bit.  Keep sampling every bit period.
+					--bitsRemaining;
+				}
+			} else if (--bitsRemaining > 0) {
+				// A data bit; shift it in from the left.
+				dataIn >>= 1;
+				if (sample)
+					dataIn |= 0x80;
+				if (bitsRemaining == 1)
+					pr2 = STOP_PERIOD;
+			} else {
+				// This is the stop bit.
+				// Either way, we're done with this byte.
+				if (!sample)
+					// But it wasn't set - must be a framing error.
+					RecordError('F', &ser_framingErrors);
+				else if (queueNextTail == dataQueueHead)  // queue is full
+					RecordError('c', &ser_overflowErrors);
+				else {
+					EnqueueByte(dataIn);
 					ser_hasData = 1;
-				} else {
-					// Otherwise, just leave the timer running for the next baud period.
-					pr2 = BAUD_PERIOD;
 				}
 			}
 			
-			pir1.TMR2IF = 0;
-		} else if (intcon.RBIF) {
-			if (!ser_error && !receiveBit) {
+			if (!bitsRemaining) {
+				// Done for the moment.  Just watch for the pin to change.
+				// We're in the stop bit (or the glitch), so the line is high
+				// unless there was a framing error, in which case the next falling edge will be a start bit.
+				t2con.TMR2ON = 0;
+				pie1.TMR2IE = 0;
+				dataIn = portb;  // end the mismatch condition
+				intcon.RBIF = 0;
+				if (sample && !receiveBit) {
+					// The next start bit began since the sample, so there won't be an edge to catch.
+					bitsRemaining = START_BIT;
+					pr2 = BIT_PERIOD;
+					tmr2 = START_NOW_PRELOAD;
+					pie1.TMR2IE = 1;
+					t2con.TMR2ON = 1;
+				} else
+					intcon.RBIE = 1;
+			}
+		} else if (intcon.RBIF && intcon.RBIE) {
+			// Reading the port clears the mismatch, so the flag can be cleared.
+			bit sample = receiveBit;
+			intcon.RBIF = 0;
+
+			if (!sample) {
 				// No byte in progress, but one seems to have just started.
-				
-				// Set up to receive 8 more data bits and 1 stop bit.
-				bitsRemaining = 9;
-				
-				// Delay one and a half baud periods before the next interrupt,
-				// so we synchronize in the middle of an incoming bit.
-				pr2 = INTRO_BAUD_PERIOD;
-				tmr2 = 36 + 34;  // (rough compensation for the delay in getting this far + the delay in processing the first bit)
+				// Check it again in the middle of the start bit.
+				intcon.RBIE = 0;
+				bitsRemaining = START_BIT;
+				pr2 = BIT_PERIOD;
+				tmr2 = START_PRELOAD;
+				pir1.TMR2IF = 0;
+				pie1.TMR2IE = 1;
 				t2con.TMR2ON = 1;
 			}
-			
-			// Clear the interrupt.
-			intcon.RBIF = 0;  // should already be done when receiveBit is read.
-		}
-				
-		// If we're done, set the interrupt on pin change;
-		// if not, we can just keep the timer interrupt on.
-		// It's one or the other - we never need both.
-		// Another way to think of it is that the IOC is a way to save
-		// processor cycles (though it also allows us to react closer 
-		// to the leading edge of the start bit).
-		if (ser_error) {
-			// Disable both our interrupts.
-			intcon.TMR2ON = 0;
-			intcon.RBIE = 0;
-			intcon.RBIF = 0;
-		} else if (!bitsRemaining) {
-			// Done for the moment.  Just watch for the pin to change.
-			intcon.RBIE = 1;
-			intcon.RBIF = 0;
-			intcon.TMR2IE = 0;
-			t2con.TMR2ON = 0;
-		} else {
-			// Not yet done.  Poll the bit at the next timer interrupt.
-			intcon.RBIE = 0;
-			pir1.TMR2IF = 0;
-			pie1.TMR2IE = 1;
-			t2con.TMR2ON = 1;
 		}
 	
 	#else
 	// !SOFTWARE_RECEIVE
 	
-		if (pir1.RCIF && !ser_error) {
+		if (pir1.RCIF) {
+			// FERR applies to the byte at the top of the FIFO, and is cleared by reading it.
 			if (rcsta.FERR) {
-				ser_errorType = 'F';
-				ser_error = 1;
-				ser_hasData = 0;
-			} else if (rcsta.OERR) {
-				ser_errorType = 'C';
-				ser_error = 1;
-				ser_hasData = 0;
+				RecordError('F', &ser_framingErrors);
+				rcreg;
 			} else if (queueNextTail == dataQueueHead) {  // queue is full
-				ser_error = 1;
-				ser_errorType = 'c';
+				// Drop the byte, so the interrupt doesn't keep firing.
+				RecordError('c', &ser_overflowErrors);
+				rcreg;
 			} else {
-				*dataQueueTail = rcreg;
-				
-				dataQueueTail = queueNextTail;
-				
-				if (++queueNextTail == queueEnd)
-					queueNextTail = dataQueue;
-					
-				ser_error = 0;
+				EnqueueByte(rcreg);
+				ser_hasData = 1;
+			}
+			
+			// On overrun, the USART stops receiving until CREN is toggled.
+			// The bytes already in its FIFO are still good, so wait until they've been read.
+			if (rcsta.OERR && !pir1.RCIF) {
+				RecordError('C', &ser_collisionErrors);
+				rcsta.CREN = 0;
+				rcsta.CREN = 1;
 			}
-
-			ser_hasData = !ser_error;
 		}
 		
 	#endif
@@ -242,17 +346,103 @@ void SerialInterrupt()
 unsigned char ReadSerial()
 {
 	unsigned char result;
-#ifdef SOFTWARE_RECEIVE
-	result = dataQueue;
-	ser_hasData = 0;
-#else
 	result = *dataQueueHead;
 	
 	// Increment and handle rollover.
 	if (++dataQueueHead == queueEnd)
 		dataQueueHead = dataQueue;
 		
+	if (result == SERIAL_LINE_END)
+		--ser_linesQueued;
+		
 	ser_hasData = (dataQueueHead != dataQueueTail);
+	return result;
+}
+
+// Returns the current tail of the queue.
+// The pointer may be wider than the processor can load in one instruction,
+// so hold off the receive interrupt while it's read, and then put it back the way it was.
+inline unsigned char* SnapshotQueueTail()
+{
+	unsigned char* result;
+#ifdef SOFTWARE_RECEIVE
+	// The tail only moves at the stop bit, so a few cycles' delay here is harmless.
+	bit wasEnabled = intcon.GIE;
+	intcon.GIE = 0;
+	result = dataQueueTail;
+	intcon.GIE = wasEnabled;
+#else
+	bit wasEnabled = pie1.RCIE;
+	pie1.RCIE = 0;
+	result = dataQueueTail;
+	pie1.RCIE = wasEnabled;
 #endif
 	return result;
 }
+
+unsigned char ReadSerialBuf(unsigned char* dst, unsigned char max)
+{
+	unsigned char* tail = SnapshotQueueTail();
+	unsigned char* src = dataQueueHead;
+	unsigned char count = 0;
+	unsigned char span;
+	
+	// At most two runs: from the head to the tail or the end of the queue,
+	// and then from the start of the queue to the tail.
+	while (src != tail && count < max) {
+		if (tail > src)
+			span = tail - src;
+		else
+			span = queueEnd - src;
+		if (span > max - count)
+			span = max - count;
+		count += span;
+		
+		// Only look for line ends if we know there are some in the queue.
+		if (ser_linesQueued)
+			while (span--) {
+				if (*src == SERIAL_LINE_END)
+					--ser_linesQueued;
+				*dst++ = *src++;
+			}
+		else
+			while (span--)
+				*dst++ = *src++;
+		
+		if (src == queueEnd)
+			src = dataQueue;
+	}
+	
+	dataQueueHead = src;
+	ser_hasData = (dataQueueHead != dataQueueTail);
+	return count;
+}
+
+unsigned char ReadSerialLine(unsigned char* dst, unsigned char max)
+{
+	if (!ser_linesQueued)
+		return 0;
+		
+	// There's a line end in the queue, so we don't need to check against the tail.
+	unsigned char* src = dataQueueHead;
+	unsigned char count = 0;
+	unsigned char c;
+	
+	while (count < max) {
+		c = *src;
+		*dst++ = c;
+		++count;
+		
+		if (++src == queueEnd)
+			src = dataQueue;
+			
+		if (c == SERIAL_LINE_END) {
+			--ser_linesQueued;
+			break;
+		}
+	}
+	
+	dataQueueHead = src;
+	ser_hasData = (dataQueueHead != dataQueueTail);
+	return count;
+}
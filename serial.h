@@ -1,7 +1,14 @@
 /* serial.h 
     Copyright (c) 2006, 2007 by Timothy J. Weber, tw@timothyweber.org.
 
-	Define SOFTWARE_RECEIVE to provide reception in software (not debugged or polished yet).
+	Define SOFTWARE_RECEIVE to provide reception in software, for chips without a spare USART.
+	The pin, baud rate and clock are set in serial-consts.h.
+	It uses Timer2 and interrupt-on-change for PORTB, so it needs both of those to itself.
+	The start bit is checked again in its middle, so glitches on the line aren't taken for bytes,
+	and each bit is sampled in its middle, except the stop bit, which is sampled a little early so the
+	next start bit isn't missed.  Senders within 3% of the baud rate are received correctly, down to
+	around 100 instruction cycles a bit (9600 baud at 4 MHz), as long as the rest of the ISR is short
+	(about 30 cycles there).  SerialSim.c checks a given clock, baud rate and ISR length.
 */
 
 #ifndef __SERIAL_H
@@ -19,7 +26,7 @@
 SERIAL_EXTERN bit ser_hasData;
 
 // If this is set, there has been some kind of error.
-// When you've recovered, call InitializeSerial().
+// Reception carries on past errors, dropping only the bad byte; call ClearSerialErrors() once you've noted it.
 SERIAL_EXTERN bit ser_error;
 
 // Set to a character representing the error type.
@@ -29,6 +36,18 @@ SERIAL_EXTERN bit ser_error;
 //   c: Collision, soft (the buffer in this module has overflowed)
 SERIAL_EXTERN char ser_errorType;
 
+// The number of framing errors (F) since ClearSerialErrors(), stopping at 255.
+SERIAL_EXTERN unsigned char ser_framingErrors;
+
+// The number of USART collisions (C) since ClearSerialErrors(), stopping at 255.
+SERIAL_EXTERN unsigned char ser_collisionErrors;
+
+// The number of bytes dropped because the queue was full (c) since ClearSerialErrors(), stopping at 255.
+SERIAL_EXTERN unsigned char ser_overflowErrors;
+
+// Clears ser_error and the error counts.
+void ClearSerialErrors();
+
 // After calling this, set GIE to start processing.
 void InitializeSerial();  // equivalent to receive, no transmit, for legacy reasons.
 void InitializeSerial2(bool useReceive, bool useTransmit);
@@ -37,9 +56,27 @@ void InitializeSerial2(bool useReceive, bool useTransmit);
 void SerialInterrupt();
 
 // Returns the next available character.
-// If this isn't called often enough, and incoming bytes collide, the Collision error is reported.
+// If this isn't called often enough, and incoming bytes collide, the Collision error is reported,
+// and the incoming bytes are dropped until there's room for them.
 unsigned char ReadSerial();
 
+// The number of complete lines (ending in SERIAL_LINE_END) waiting in the input queue.
+// Maintained by SerialInterrupt() as bytes arrive, so you don't have to scan for line ends.
+SERIAL_EXTERN unsigned char ser_linesQueued;
+
+// Copies up to max waiting characters into dst, and returns the number copied.
+// Returns 0 if nothing is waiting.
+// Much cheaper than calling ReadSerial() per character: the queue is copied
+// in at most two contiguous runs (before and after it wraps around).
+unsigned char ReadSerialBuf(unsigned char* dst, unsigned char max);
+
+// If a complete line is waiting, copies it into dst, including the SERIAL_LINE_END
+// character, and returns its length.  Returns 0 if no complete line is waiting yet.
+// If the line is longer than max, only the first max characters are copied,
+// and the rest are returned by the next call.
+// The result is not null-terminated.
+unsigned char ReadSerialLine(unsigned char* dst, unsigned char max);
+
 // Sends the specified character out the serial port.
 inline void WriteSerial(char c)
 {